@@ -3,13 +3,27 @@
  * @brief 		用于定义FOC控制器的配置常量
  * @detail
  * @author      Liu-Curiousity (2675794963@qq.com)
- * @date        26-5-28
- * @version 	V2.0.0
+ * @date        26-10-17
+ * @version 	V2.12.0
  * @note 		
  * @warning	    
  * @par 		历史版本
                 V1.0.0创建于25-5-5
                 V2.0.0创建于26-5-28, 添加硬件版本检测
+                V2.1.0创建于26-10-17, 添加速度观测方式配置
+                V2.2.0创建于26-10-17, 添加多圈位置掉电保存配置
+                V2.3.0创建于26-10-17, 添加电流采样过采样倍数配置
+                V2.4.0创建于26-10-17, 添加三电阻采样配置
+                V2.5.0创建于26-10-17, 添加电流零点跟踪配置
+                V2.6.0创建于26-10-17, 添加母线电压DMA采样配置
+                V2.7.0创建于26-10-17, 添加占空比按母线电压归一化配置
+                V2.8.0创建于26-10-17, 添加调制方式配置
+                V2.9.0创建于26-10-17, 添加弱磁与过调制配置
+                V2.10.0创建于26-10-17, 添加PWM频率与死区补偿配置
+                V2.11.0创建于26-10-17, 添加电流环倍频(PWM波峰波谷双采样)配置
+                V2.11.1创建于26-10-17, 未经硬件验证的功能默认关闭,保持原有行为
+                V2.11.2创建于26-10-17, 添加在线电流采样配置,下桥采样电阻的硬件禁止开启电流环倍频
+                V2.12.0创建于26-10-17, 添加编码器DMA读取配置,默认关闭
  * @copyright   (c) 2026 QDrive
  * */
 
@@ -46,9 +60,36 @@ extern "C" {
 #define FOC_MAX_CURRENT             1.65f   // 最大电流,单位A
 #define FOC_ABSOLUTE_MIN_VOLTAGE    6.0f    // 绝对最小电压,单位V
 #define FOC_ABSOLUTE_MAX_VOLTAGE    27.0f   // 绝对最大电压,单位V
+#define FOC_PWM_FREQUENCY           20000   // PWM频率(TIM1中心对齐),单位Hz
 
 /*==========================配置参数==========================*/
 #define FOC_MAX_SPEED               1000.0f // 最大转速,单位rpm
+#define FOC_SPEED_OBSERVER_PLL      0       // 速度观测方式,1为PLL观测器,0为角度差分+二阶低通(FOC_SPEED_KP/KI按此整定)
+#define FOC_SPEED_PLL_BANDWIDTH     300.0f  // PLL观测器带宽,单位Hz
+#define FOC_ENCODER_DMA             0       // 编码器由TIM1 CC4触发SPI DMA读取,0为HAL阻塞读取
+#define FOC_CURRENT_OVERSAMPLING    1       // 电流采样硬件过采样倍数,1/2/4/8/16,1为单次采样(CCR4触发点不变)
+#define FOC_CURRENT_THREE_SHUNT     0       // 三电阻采样,1为开启(需驱动板将W相采样电阻接到ADC12共用引脚)
+#define FOC_CURRENT_W_CHANNEL       1       // W相的ADC通道号,即ADC12_INx的x
+#define FOC_CURRENT_W_INVERTED      0       // W相运放极性,1为与U相相同,0为与V相相同
+#define FOC_CURRENT_OFFSET_TRACK    0       // 电机停止且静止时跟踪电流采样零点漂移,1为开启
+#define FOC_CURRENT_OFFSET_TAU      10.0f   // 零点跟踪时间常数,单位s
+#define FOC_CURRENT_INLINE_SENSING  0       // 相电流在线采样(相线串联电阻或霍尔传感器),原装QD4310为下桥采样电阻,为0
+#define FOC_CURRENT_DOUBLE_RATE     0       // 电流环在PWM波峰和波谷各运行一次,1为开启(需FOC_CURRENT_INLINE_SENSING,原装QD4310波峰处读不到有效电流)
+#define FOC_CURRENT_LOOP_FREQUENCY  (FOC_PWM_FREQUENCY * (FOC_CURRENT_DOUBLE_RATE ? 2 : 1)) // 电流环频率,单位Hz
+#define FOC_DOUBLE_RATE_MAX_LOAD    0.7f    // 开启倍频时触发到退出电流环中断的最大耗时占半个PWM周期的上限
+#define FOC_DOUBLE_RATE_PROFILE_MS  100     // 开启倍频前以单倍频实测中断耗时的时长,单位ms
+#define FOC_VBUS_DMA                0       // 母线电压由PWM触发DMA采样并在电流环中更新,0为FOCTask中1kHz轮询
+#define FOC_VBUS_COMPENSATION       0       // 占空比按实时母线电压归一化,电流环增益不随母线电压变化(以额定电压整定)
+#define FOC_MODULATION_SVPWM        0       // 1为SVPWM(min-max零序注入,相电压最大V_bus/√3),0为SPWM(最大V_bus/2)
+#define FOC_OVERMODULATION          1.0f    // SVPWM最大电压利用率,1为线性调制,大于1过调制,越大越接近六步方波
+#define FOC_FW_MAX_CURRENT          0.0f    // 最大弱磁电流(负D轴电流),单位A,0为关闭
+#define FOC_FW_THRESHOLD            0.95f   // 开始弱磁的电压利用率
+#define FOC_FW_GAIN                 200.0f  // 弱磁积分增益,单位A/s
+#define FOC_DEAD_TIME               0.0f    // 死区补偿的默认死区时间,单位s,0为不补偿,可由calibrate deadtime校准并储存
+#define FOC_DEAD_TIME_BAND          0.05f   // 死区补偿在电流过零附近线性过渡的范围,单位A
+#define FOC_DEAD_TIME_CAL_CURRENT   0.8f    // 死区校准的最大D轴电流,单位A
+#define FOC_POSITION_PERSIST        0       // 掉电时保存多圈位置,1为开启(每次掉电擦写一次Flash页,上电恢复后再擦写一次作废)
+#define FOC_POSITION_HYSTERESIS     1.0f    // 掉电检测回差,电压回升到最小电压加此值后才重新准备保存,单位V
 
 #define FOC_CURRENT_KP              10.0f
 #define FOC_CURRENT_KI              20000.0f
@@ -60,6 +101,10 @@ extern "C" {
 #define FOC_ANGLE_KI                0.0f
 #define FOC_ANGLE_KD                0.0f
 
+#if FOC_CURRENT_DOUBLE_RATE && !FOC_CURRENT_INLINE_SENSING
+#error "FOC_CURRENT_DOUBLE_RATE requires FOC_CURRENT_INLINE_SENSING: low-side shunts carry no phase current at the PWM peak"
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -3,8 +3,8 @@
  * @brief       shell 接口函数
  * @details
  * @author      Liu-Curiousity (2675794963@qq.com)
- * @date        2026-7-2
- * @version     V1.5.3
+ * @date        2026-10-17
+ * @version     V1.23.5
  * @note
  * @warning
  * @par         历史版本:
@@ -20,18 +20,73 @@
  *		        V1.5.1创建于2026-5-5, 修复角度步进模式和速度模式均错误显示角度模式的问题
  *		        V1.5.2创建于2026-5-30, 补充打印校准信息
  *		        V1.5.3创建于2026-7-2, 补充打印错误信息
+ *		        V1.6.0创建于2026-10-17, 添加perf命令,显示电流环中断分阶段耗时统计
+ *		        V1.7.0创建于2026-10-17, 添加scope命令,电流环频率采集波形并以二进制帧输出
+ *		        V1.8.0创建于2026-10-17, perf命令显示控制中断超时统计,status显示超时警告
+ *		        V1.9.0创建于2026-10-17, 添加tasks命令,显示任务CPU占用、栈余量和堆使用情况
+ *		        V1.10.0创建于2026-10-17, 添加perf encoder,对比编码器各读取方式的耗时
+ *		        V1.11.0创建于2026-10-17, status显示编码器错误帧统计
+ *		        V1.12.0创建于2026-10-17, 添加speed.pll_bw配置项,设置PLL速度观测器带宽
+ *		        V1.13.0创建于2026-10-17, 添加ctrl position多圈角度控制,status显示多圈位置
+ *		        V1.14.0创建于2026-10-17, 添加current.oversampling配置项,scope显示采集结果的电流噪声统计
+ *		        V1.15.0创建于2026-10-17, 添加perf current,对比电流读取与坐标变换的浮点/定点实现耗时
+ *		        V1.16.0创建于2026-10-17, status显示电流零点及跟踪状态,添加adc.offset_tau配置项
+ *		        V1.17.0创建于2026-10-17, 添加pwm.vbus_comp配置项,开关占空比按母线电压归一化
+ *		        V1.18.0创建于2026-10-17, 添加perf pwm,对比占空比设置的HAL/寄存器实现耗时及被推迟的更新事件
+ *		        V1.19.0创建于2026-10-17, 添加pwm.svpwm配置项,切换SVPWM/SPWM调制
+ *		        V1.20.0创建于2026-10-17, 添加pwm.overmod、fw.max_current、fw.threshold配置项,status显示电压利用率和弱磁电流
+ *		        V1.21.0创建于2026-10-17, 添加calibrate deadtime死区校准和pwm.deadtime配置项
+ *		        V1.22.0创建于2026-10-17, perf和scope按实际电流环频率显示,enable提示电流环倍频未能开启
+ *		        V1.22.1创建于2026-10-17, ctrl position返回CtrlPosition()的结果
+ *		        V1.22.2创建于2026-10-17, fw.max_current范围以电流限制为上限
+ *		        V1.22.3创建于2026-10-17, 死区校准过程中电机停止、出错或转子转动时放弃结果
+ *		        V1.23.0创建于2026-10-17, 添加perf crc,在目标板上对比硬件CRC与查表法的结果和耗时,status显示CRC自检失败
+ *		        V1.23.1创建于2026-10-17, status显示编码器DMA读取未触发或超时的次数
+ *		        V1.23.2创建于2026-10-17, perf encoder显示SPI时钟和帧宽度,注明只测量板上的MT6826S
+ *		        V1.23.3创建于2026-10-17, perf pwm不再显示推迟的更新事件
+ *		        V1.23.4创建于2026-10-17, 死区校准由QD4310::injectCurrentD()注入D轴电流
+ *		        V1.23.5创建于2026-10-17, status显示倍频未能开启时实测耗时、预算和处理方法
  * @copyright   (c) 2026 QDrive
  */
 
 #include <algorithm>
+#include <cmath>
+#include <numbers>
 
 #include "shell_cpp.h"
 #include "usbd_cdc_if.h"
+#include "spi.h"
 #include "retarget/retarget.h"
 #include "QD4310.h"
 #include "QDrive_cfg.h"
+#include "DWT_Profiler.h"
+#include "Oscilloscope.h"
+#include "DeadlineMonitor.h"
+#include "Encoder_MT6826S.h"
+#include "PLL_SpeedObserver.h"
+#include "CurrentSensor_Embed.h"
+#include "CurrentOffsetTracker.h"
+#include "FixedPointFOC.h"
+#include "BLDC_Driver_DRV8300.h"
+#include "BLDC_Modulator.h"
+#include "FieldWeakening.h"
+#include "Crc8Engine.h"
+#include "FreeRTOS.h"
+#include "task.h"
 
 extern QD4310 qd4310;
+extern Encoder_MT6826S bldc_encoder;
+extern CurrentSensor_Embed current_sensor;
+extern BLDC_Driver_DRV8300 bldc_driver;
+extern BLDC_Modulator modulator;
+extern FieldWeakening field_weakening;
+extern uint32_t double_rate_busy;
+#if FOC_CURRENT_OFFSET_TRACK
+extern CurrentOffsetTracker current_offset_tracker;
+#endif
+#if FOC_SPEED_OBSERVER_PLL
+extern PLL_SpeedObserver SpeedFilter;
+#endif
 extern Shell shell;
 
 #define PROMPT_DISABLE_FIRST "QDrive is running, please disable it first"
@@ -64,13 +119,49 @@ public:
         print_len("  CtrlMode     : %s ctrl",
                   qd4310.getCtrlType().type == CtrlType::CurrentCtrl ? CtrlItems[0].name :
                   qd4310.getCtrlType().type == CtrlType::SpeedCtrl ? CtrlItems[1].name :
+                  qd4310.isPositionCtrl() ? CtrlItems[5].name :
                   qd4310.getCtrlType().type == CtrlType::AngleCtrl ? CtrlItems[2].name :
                   qd4310.getCtrlType().type == CtrlType::StepAngleCtrl ? CtrlItems[3].name :
                   qd4310.getCtrlType().type == CtrlType::LowSpeedCtrl ? CtrlItems[4].name : "Unknown");
         print_len("  Current      : %.2f A", qd4310.getCurrent());
         print_len("  Speed        : %.2f rpm", qd4310.getSpeed());
         print_len("  Angle        : %.2f rad", qd4310.getAngle());
+        print_len("  Position     : %.3f turns", QD4310::position_to_radian(qd4310.getPosition()) /
+                                                 (2 * std::numbers::pi_v<float>));
         print_len("  Voltage      : %.2f V", qd4310.getVoltage());
+        print_len("  Encoder err  : crc %u, status %u, dma missed %u", bldc_encoder.crc_errors(),
+                  bldc_encoder.status_errors(), bldc_encoder.dma_misses());
+        float iu_offset, iv_offset, iw_offset;
+        current_sensor.get_offset(iu_offset, iv_offset, iw_offset);
+#if FOC_CURRENT_OFFSET_TRACK
+        print_len("  Curr offset  : U %.1f mA, V %.1f mA, W %.1f mA (%s, %u samples, %u rejected)",
+                  iu_offset * 1e3f, iv_offset * 1e3f, iw_offset * 1e3f,
+                  current_offset_tracker.is_tracking() ? "tracking" : "holding",
+                  current_offset_tracker.get_samples(), current_offset_tracker.get_rejected());
+#else
+        print_len("  Curr offset  : U %.1f mA, V %.1f mA, W %.1f mA", iu_offset * 1e3f, iv_offset * 1e3f,
+                  iw_offset * 1e3f);
+#endif
+        print_len("  Modulation   : utilization %.3f, field weakening Id %.3f A", modulator.get_utilization(),
+                  field_weakening.get_current());
+        if (qd4310.error_code & RateError) {
+            print_len("  Error        : current loop double rate refused, ISR %u cycles, budget %u cycles",
+                      double_rate_busy, double_rate_budget());
+            if (double_rate_busy > double_rate_budget())
+                print_len("                 reduce ISR load or set FOC_CURRENT_DOUBLE_RATE 0 and rebuild");
+            else if (double_rate_busy == 0)
+                print_len("                 no ISR measured, set FOC_CURRENT_DOUBLE_RATE 0 and rebuild");
+            else
+                print_len("                 ADC trigger not switched, set FOC_CURRENT_DOUBLE_RATE 0 and rebuild");
+        }
+        if (qd4310.error_code & OverrunError)
+            print_len("  Warning      : control loop overrun, see perf");
+        if (qd4310.error_code & EncoderError)
+            print_len("  Warning      : encoder frames rejected or DMA reads missed%s",
+                      bldc_encoder.faulted() ? ", encoder lost" : "");
+        if (Crc8Engine_Hardware::is_fallback())
+            print_len("  Warning      : CRC unit self-test failed (%u mismatches), using table CRC, see perf crc",
+                      Crc8Engine_Hardware::get_mismatches());
     }
 
     static void foc_config_help() {
@@ -193,6 +284,9 @@ public:
             print_len("Enable failed, please calibrate first");
         } else if (qd4310.error_code & VoltageError) {
             print_len("Enable failed, voltage error");
+        } else if (qd4310.error_code & RateError) {
+            print_len("Enable failed, current loop double rate refused (ISR %u cycles, budget %u), see status",
+                      double_rate_busy, double_rate_budget());
         } else {
             print_len("Enable failed, unknown error");
         }
@@ -203,7 +297,11 @@ public:
         print_len("QDrive disabled");
     }
 
-    static void foc_calibrate() {
+    static void foc_calibrate(const int argc, char *argv[]) {
+        if (argc >= 2 && strcmp(argv[1], "deadtime") == 0) {
+            foc_calibrate_dead_time();
+            return;
+        }
         if (qd4310.started) {
             print_len(PROMPT_DISABLE_FIRST);
             return;
@@ -241,6 +339,67 @@ public:
         }
     }
 
+    /**
+     * @brief 死区校准: 电流环保持Q轴电流为0,依次注入两个正D轴电流使转子保持不动,
+     *        由关闭补偿时的D轴电压求电压-电流直线的截距,即死区造成的电压损失
+     * @note 每次等待后检查电机仍在运行且无错误,两次注入之间转子转过超过MAX_DRIFT则放弃结果,均不储存
+     */
+    static void foc_calibrate_dead_time() {
+        constexpr float CURRENTS[] = {0.3f * FOC_DEAD_TIME_CAL_CURRENT, FOC_DEAD_TIME_CAL_CURRENT};
+        constexpr uint32_t SAMPLES = 200;
+        constexpr float MAX_DRIFT = 0.05f; // 允许的电角度变化,单位rad
+        if (qd4310.started) {
+            print_len(PROMPT_DISABLE_FIRST);
+            return;
+        }
+        if (!qd4310.start()) {
+            print_len("Dead time calibration failed, QDrive cannot be enabled, see status");
+            return;
+        }
+        print_len("Dead time calibration started, rotor will be held by %.2f A, please wait...", CURRENTS[1]);
+        const float saved = modulator.get_dead_time();
+        modulator.set_dead_time(0, FOC_DEAD_TIME_BAND);
+        qd4310.Ctrl({CtrlType::CurrentCtrl, 0});
+        const auto aborted = [] { return !qd4310.started || (qd4310.error_code & ~QD4310::WARNING_MASK); };
+        float vd[2]{}, angle[2]{};
+        bool ok = true;
+        for (uint32_t i = 0; i < 2 && ok; ++i) {
+            ok = qd4310.injectCurrentD(CURRENTS[i]);
+            delay(200); // 等待电流和转子稳定
+            ok = ok && !aborted();
+            angle[i] = qd4310.getElectricAngle();
+            for (uint32_t j = 0; j < SAMPLES && ok; ++j) {
+                vd[i] += modulator.get_voltage_d(qd4310.getElectricAngle()) / SAMPLES;
+                delay(1);
+                ok = !aborted();
+            }
+        }
+        const float theta = qd4310.getElectricAngle();
+        qd4310.injectCurrentD(0);
+        qd4310.stop();
+        if (!ok) {
+            modulator.set_dead_time(saved, FOC_DEAD_TIME_BAND);
+            print_len("Dead time calibration aborted: QDrive stopped or error occurred, see status");
+            return;
+        }
+        const float drift = std::remainder(theta - angle[0], 2 * std::numbers::pi_v<float>);
+        if (fabsf(drift) > MAX_DRIFT) {
+            modulator.set_dead_time(saved, FOC_DEAD_TIME_BAND);
+            print_len("Dead time calibration failed: rotor moved %.3f rad (electric), keep it unloaded", drift);
+            return;
+        }
+        const float ratio = BLDC_Modulator::dead_time_from_voltages(theta, CURRENTS[0], vd[0], CURRENTS[1], vd[1]);
+        const float dead_time = ratio / FOC_PWM_FREQUENCY;
+        if (!qd4310.setDeadTime(dead_time)) {
+            modulator.set_dead_time(saved, FOC_DEAD_TIME_BAND);
+            print_len("Dead time calibration failed: %.0f ns out of range (0-2000 ns)", dead_time * 1e9f);
+            return;
+        }
+        modulator.set_dead_time(ratio, FOC_DEAD_TIME_BAND);
+        qd4310.freeze_storage(STORAGE_DEAD_TIME_OK);
+        print_len("Dead time calibration completed: %.0f ns (Vd %.4f, %.4f of Vbus)", dead_time * 1e9f, vd[0], vd[1]);
+    }
+
     static void foc_restore() {
         if (qd4310.started) {
             print_len(PROMPT_DISABLE_FIRST);
@@ -256,6 +415,7 @@ public:
             return;
         }
         qd4310.restore_calibration(); // 恢复出厂设置
+        modulator.set_dead_time(qd4310.getDeadTime() * FOC_PWM_FREQUENCY, FOC_DEAD_TIME_BAND);
         print_len("Factory restore completed");
         foc_config_list();
     }
@@ -277,11 +437,413 @@ public:
         }
         qd4310.freeze_storage(
             static_cast<StorageStatus>(STORAGE_PID_PARAMETER_OK | // 储存PID参数
-                                       STORAGE_PLUG_OK)           // 储存ID
+                                       STORAGE_PLUG_OK |          // 储存ID
+                                       STORAGE_DEAD_TIME_OK)      // 储存死区时间
         );
         print_len("Store operation completed");
     }
 
+    static void foc_perf_help() {
+        print_len("Usage: perf [--help | hist | reset | encoder | current | pwm | crc]");
+        print_len("");
+        print_len("  perf         : show current loop ISR timing per stage");
+        print_len("  perf hist    : show cycle histogram per stage");
+        print_len("  perf reset   : clear statistics and overrun warning");
+        print_len("  perf encoder : compare encoder read paths (HAL/register/DMA), clears statistics");
+        print_len("  perf current : compare float/fixed-point current read and transforms");
+        print_len("  perf pwm     : compare duty write paths (HAL/register/compare)");
+        print_len("  perf crc     : check hardware CRC against table CRC and compare timing");
+    }
+
+    static void foc_perf(const int argc, char *argv[]) {
+        if (argc >= 2 && strcmp(argv[1], "--help") == 0) {
+            foc_perf_help();
+            return;
+        }
+        if (argc >= 2 && strcmp(argv[1], "reset") == 0) {
+            DWT_Profiler::reset();
+            DeadlineMonitor::reset();
+            qd4310.clearError();
+            print_len("Profiler statistics cleared");
+            return;
+        }
+        if (argc >= 2 && strcmp(argv[1], "encoder") == 0) {
+            foc_perf_encoder();
+            return;
+        }
+        if (argc >= 2 && strcmp(argv[1], "current") == 0) {
+            foc_perf_current();
+            return;
+        }
+        if (argc >= 2 && strcmp(argv[1], "pwm") == 0) {
+            foc_perf_pwm();
+            return;
+        }
+        if (argc >= 2 && strcmp(argv[1], "crc") == 0) {
+            foc_perf_crc();
+            return;
+        }
+
+        const uint32_t budget = DWT_Profiler::get_budget();
+        const float cycles_per_us = static_cast<float>(SystemCoreClock) / 1e6f;
+        const auto total = DWT_Profiler::snapshot(DWT_Profiler::STAGE_TOTAL);
+        print_len("Current loop ISR profile (%u Hz, %u samples, budget %u cycles):", current_loop_frequency(),
+                  total.count, budget);
+        if (total.count == 0) return;
+
+        if (argc >= 2 && strcmp(argv[1], "hist") == 0) {
+            for (uint8_t stage = 0; stage < DWT_Profiler::STAGE_NUM; ++stage) {
+                const auto stat = DWT_Profiler::snapshot(static_cast<DWT_Profiler::Stage>(stage));
+                print_len("  %s:", DWT_Profiler::STAGE_NAMES[stage]);
+                for (uint8_t bin = 0; bin < DWT_Profiler::HIST_BINS; ++bin) {
+                    if (stat.hist[bin] == 0) continue;
+                    if (bin == DWT_Profiler::HIST_BINS - 1)
+                        print_len("    >=%5u      : %u", DWT_Profiler::Statistics::bin_lower(bin), stat.hist[bin]);
+                    else
+                        print_len("    %5u-%-5u : %u", DWT_Profiler::Statistics::bin_lower(bin),
+                                  DWT_Profiler::Statistics::bin_lower(bin + 1) - 1, stat.hist[bin]);
+                }
+            }
+            return;
+        }
+
+        print_len("  %-14s %8s %8s %8s %9s", "Stage", "min", "mean", "max", "mean(us)");
+        for (uint8_t stage = 0; stage < DWT_Profiler::STAGE_NUM; ++stage) {
+            const auto stat = DWT_Profiler::snapshot(static_cast<DWT_Profiler::Stage>(stage));
+            if (stat.count == 0) {
+                print_len("  %-14s %8s %8s %8s %9s", DWT_Profiler::STAGE_NAMES[stage], "-", "-", "-", "-");
+                continue;
+            }
+            print_len("  %-14s %8u %8u %8u %9.2f", DWT_Profiler::STAGE_NAMES[stage],
+                      stat.min, stat.mean(), stat.max, static_cast<float>(stat.mean()) / cycles_per_us);
+        }
+        print_len("  Load: mean %.1f%%, peak %.1f%%",
+                  100.0f * static_cast<float>(total.mean()) / static_cast<float>(budget),
+                  100.0f * static_cast<float>(total.max) / static_cast<float>(budget));
+        foc_deadline();
+    }
+
+    /**
+     * @brief 依次切换编码器读取方式,由电流环中断中的DWT统计得到get_angle()耗时
+     * @note QD4310只焊接了MT6826S,MT6825和KTH7823无法在本板上测量
+     */
+    static void foc_perf_encoder() {
+        static constexpr struct {
+            SPI_ReadPath path;
+            const char *name;
+        } PATHS[] = {
+            {SPI_ReadPath::HAL, "HAL"},
+            {SPI_ReadPath::REGISTER, "register"},
+            {SPI_ReadPath::DMA, "DMA"},
+        };
+        const float cycles_per_us = static_cast<float>(SystemCoreClock) / 1e6f;
+        const SPI_ReadPath saved = bldc_encoder.read_path;
+        const SPI_TypeDef *spi = hspi1.Instance;
+        const uint32_t spi_clock = HAL_RCC_GetPCLK2Freq() >> (((spi->CR1 & SPI_CR1_BR) >> SPI_CR1_BR_Pos) + 1);
+        print_len("Encoder_MT6826S get_angle() per read path (SPI %.2f MHz, %u-bit frames):",
+                  static_cast<float>(spi_clock) / 1e6f, ((spi->CR2 & SPI_CR2_DS) >> SPI_CR2_DS_Pos) + 1);
+        print_len("  %-10s %8s %8s %8s %9s %8s", "Path", "min", "mean", "max", "mean(us)", "samples");
+        for (const auto& [path, name] : PATHS) {
+            bldc_encoder.read_path = path;
+            delay(5); // 等待读取方式切换完成
+            DWT_Profiler::reset();
+            delay(200);
+            const auto stat = DWT_Profiler::snapshot(DWT_Profiler::STAGE_ENCODER_READ);
+            if (stat.count == 0) {
+                print_len("  %-10s %8s %8s %8s %9s %8u", name, "-", "-", "-", "-", 0U);
+                continue;
+            }
+            print_len("  %-10s %8u %8u %8u %9.2f %8u", name, stat.min, stat.mean(), stat.max,
+                      static_cast<float>(stat.mean()) / cycles_per_us, stat.count);
+        }
+        bldc_encoder.read_path = saved;
+        DWT_Profiler::reset();
+    }
+
+    /**
+     * @brief 关中断循环调用各实现,由DWT计数得到单次耗时(已扣除空循环开销)
+     * @note 读取的是最近一次注入转换的JDR,结果与中断中计算的相同,不影响电流环
+     */
+    static void foc_perf_current() {
+        static constexpr uint32_t LOOPS = 1000;
+        static volatile float sink_f;
+        static volatile FixedPointFOC::q15 sink_q;
+        const float cycles_per_us = static_cast<float>(SystemCoreClock) / 1e6f;
+        const auto measure = [](auto&& body) {
+            const uint32_t primask = __get_PRIMASK();
+            __disable_irq();
+            const uint32_t start = DWT_Profiler::now();
+            for (uint32_t i = 0; i < LOOPS; ++i) body(i);
+            const uint32_t cycles = DWT_Profiler::now() - start;
+            __set_PRIMASK(primask);
+            return cycles;
+        };
+        const uint32_t overhead = measure([](uint32_t) { sink_f = 0.0f; });
+        const auto report = [&](const char *name, const uint32_t cycles) {
+            const float per_call = static_cast<float>(cycles > overhead ? cycles - overhead : 0) / LOOPS;
+            print_len("  %-22s %8.1f %9.3f", name, per_call, per_call / cycles_per_us);
+        };
+
+        print_len("Current path per call (%u loops, oversampling x%u):", LOOPS, current_sensor.get_oversampling());
+        print_len("  %-22s %8s %9s", "Path", "cycles", "us");
+        // V1.1.0的update(): 先减零点再乘系数、加偏置;偏置取运行时值,只比较耗时
+        const float mid = 2048.0f * static_cast<float>(current_sensor.get_oversampling());
+        const float scale = CurrentSensor_Embed::LSB / static_cast<float>(current_sensor.get_oversampling());
+        const float iu_offset = current_sensor.iu, iv_offset = current_sensor.iv, iw_offset = current_sensor.iw;
+        report("read float (ref)", measure([&](uint32_t) {
+            const float iu = iu_offset + (mid - static_cast<float>(hadc2.Instance->JDR1)) * scale;
+            const float iv = iv_offset + (static_cast<float>(hadc1.Instance->JDR1) - mid) * scale;
+            sink_f = iu;
+            sink_f = iw_offset - (iu + iv);
+        }));
+        report("read float (folded)", measure([](uint32_t) {
+            current_sensor.update();
+            sink_f = current_sensor.iv;
+        }));
+        report("read q15", measure([](uint32_t) {
+            FixedPointFOC::q15 iu, iv;
+            current_sensor.update_q15(iu, iv);
+            sink_q = iv;
+        }));
+        report("clarke+park float", measure([](const uint32_t i) {
+            const float iu = sink_f, iv = sink_f;
+            const float theta = static_cast<float>(i) * 0.001f;
+            const float alpha = iu;
+            const float beta = (iu + 2 * iv) * (1.0f / std::numbers::sqrt3_v<float>);
+            const float s = sinf(theta), c = cosf(theta);
+            sink_f = alpha * c + beta * s;
+            sink_f = beta * c - alpha * s;
+        }));
+        report("clarke+park q15", measure([](const uint32_t i) {
+            const FixedPointFOC::q15 iu = sink_q, iv = sink_q;
+            const auto theta = static_cast<uint16_t>(i << 6);
+            FixedPointFOC::q15 alpha, beta, d, q;
+            FixedPointFOC::clarke(iu, iv, alpha, beta);
+            FixedPointFOC::park(alpha, beta, FixedPointFOC::sin(theta), FixedPointFOC::cos(theta), d, q);
+            sink_q = d;
+            sink_q = q;
+        }));
+    }
+
+    /**
+     * @brief 关中断循环调用各占空比设置实现,由DWT计数得到单次耗时(已扣除空循环开销)
+     * @note 写入的是当前比较值,运行中测量不影响输出
+     */
+    static void foc_perf_pwm() {
+        static constexpr uint32_t LOOPS = 1000;
+        static volatile float sink_f;
+        TIM_TypeDef *const tim = htim1.Instance;
+        const uint32_t ccr_u = tim->CCR1, ccr_v = tim->CCR3, ccr_w = tim->CCR2;
+        const float max_duty = bldc_driver.get_max_duty();
+        // 加0.5使截断后得到原比较值
+        const float du = (static_cast<float>(ccr_u) + 0.5f) / max_duty;
+        const float dv = (static_cast<float>(ccr_v) + 0.5f) / max_duty;
+        const float dw = (static_cast<float>(ccr_w) + 0.5f) / max_duty;
+        const float cycles_per_us = static_cast<float>(SystemCoreClock) / 1e6f;
+        const auto measure = [](auto&& body) {
+            const uint32_t primask = __get_PRIMASK();
+            __disable_irq();
+            const uint32_t start = DWT_Profiler::now();
+            for (uint32_t i = 0; i < LOOPS; ++i) body();
+            const uint32_t cycles = DWT_Profiler::now() - start;
+            __set_PRIMASK(primask);
+            return cycles;
+        };
+        const uint32_t overhead = measure([] { sink_f = 0.0f; });
+        const auto report = [&](const char *name, const uint32_t cycles) {
+            const float per_call = static_cast<float>(cycles > overhead ? cycles - overhead : 0) / LOOPS;
+            print_len("  %-22s %8.1f %9.3f", name, per_call, per_call / cycles_per_us);
+        };
+
+        print_len("Duty write per call (%u loops):", LOOPS);
+        print_len("  %-22s %8s %9s", "Path", "cycles", "us");
+        // V3.0.2的set_duty(): 检查使能、浮点乘MaxDuty后经HAL宏写入
+        report("HAL (ref)", measure([&] {
+            if (bldc_driver.enabled) {
+                __HAL_TIM_SET_COMPARE(&htim1, TIM_CHANNEL_1, static_cast<uint32_t>(du * max_duty));
+                __HAL_TIM_SET_COMPARE(&htim1, TIM_CHANNEL_3, static_cast<uint32_t>(dv * max_duty));
+                __HAL_TIM_SET_COMPARE(&htim1, TIM_CHANNEL_2, static_cast<uint32_t>(dw * max_duty));
+            }
+        }));
+        report("set_duty", measure([&] { bldc_driver.set_duty(du, dv, dw); }));
+        report("set_compare", measure([&] { bldc_driver.set_compare(ccr_u, ccr_v, ccr_w); }));
+    }
+
+    /**
+     * @brief 以查表法为参考自检硬件CRC配置,并按通信帧长(4、9字节)比较单帧耗时
+     * @note 硬件CRC与通信任务共用,compute_hardware()在临界区内完成,测量期间通信帧不受影响;
+     *       不关中断,取LOOPS次中的最小耗时(已扣除计数开销),即未被中断打断的单次耗时
+     */
+    static void foc_perf_crc() {
+        static constexpr uint32_t LOOPS = 1000;
+        static volatile uint8_t sink;
+        static constexpr uint8_t FRAME[9] = {0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC, 0xDE, 0xF0, 0x5A};
+        const float cycles_per_us = static_cast<float>(SystemCoreClock) / 1e6f;
+        const auto minimum = [](auto&& body) {
+            uint32_t best = UINT32_MAX;
+            for (uint32_t i = 0; i < LOOPS; ++i) {
+                const uint32_t start = DWT_Profiler::now();
+                body();
+                best = std::min(best, DWT_Profiler::now() - start);
+            }
+            return best;
+        };
+        const uint32_t overhead = minimum([] { sink = 0; });
+        const auto measure = [&](auto&& body) {
+            const uint32_t cycles = minimum(body);
+            return cycles > overhead ? cycles - overhead : 0;
+        };
+
+        const uint32_t mismatches = Crc8Engine_Hardware::self_test();
+        print_len("CRC8 self-test: %u mismatches (hardware vs table)%s", mismatches,
+                  Crc8Engine_Hardware::is_fallback() ? ", communication uses table CRC" : "");
+        print_len("CRC8 per frame (min of %u calls):", LOOPS);
+        print_len("  %-10s %6s %8s %9s", "Backend", "bytes", "cycles", "us");
+        for (const uint32_t len : {4u, 9u}) {
+            const uint32_t hardware = measure([len] { sink = Crc8Engine_Hardware::compute_hardware(FRAME, len); });
+            const uint32_t table = measure([len] { sink = Crc8Engine_Software::compute(FRAME, len); });
+            print_len("  %-10s %6u %8u %9.3f", "hardware", len, hardware, static_cast<float>(hardware) / cycles_per_us);
+            print_len("  %-10s %6u %8u %9.3f", "table", len, table, static_cast<float>(table) / cycles_per_us);
+        }
+    }
+
+    static void foc_deadline() {
+        const float cycles_per_us = static_cast<float>(SystemCoreClock) / 1e6f;
+        print_len("Deadline (us):");
+        print_len("  %-14s %8s %9s %9s %9s %8s %8s", "Loop", "period", "max_intv", "max_lat", "max_busy",
+                  "overrun", "missed");
+        for (uint8_t channel = 0; channel < DeadlineMonitor::CHANNEL_NUM; ++channel) {
+            const auto stat = DeadlineMonitor::snapshot(static_cast<DeadlineMonitor::Channel>(channel));
+            print_len("  %-14s %8.1f %9.1f %9.2f %9.2f %8u %8u", DeadlineMonitor::CHANNEL_NAMES[channel],
+                      static_cast<float>(stat.period) / cycles_per_us,
+                      static_cast<float>(stat.max_interval) / cycles_per_us,
+                      static_cast<float>(stat.max_latency) / cycles_per_us,
+                      static_cast<float>(stat.max_busy) / cycles_per_us,
+                      stat.overruns, stat.missed);
+        }
+    }
+
+    static void foc_scope_help() {
+        print_len("Usage: scope [--help | arm TRIGGER [LEVEL] [PRE] [DECIMATION] | force | stop | dump]");
+        print_len("");
+        print_len("  scope                 : show capture status");
+        print_len("  scope arm TRIGGER ... : start capture, LEVEL in A or rpm, PRE samples before trigger");
+        print_len("  scope force           : trigger now");
+        print_len("  scope stop            : abort capture");
+        print_len("  scope dump            : send captured data as binary frames");
+        print_len("");
+        print("Triggers:");
+        for (const auto name : Oscilloscope::TRIGGER_NAMES) print(" %s", name);
+        print_len("");
+        print_len("Frame: A5 5A | type | seq(2) | len | payload | CRC8, little endian");
+        print_len("  0x01 info : depth(2) trigger_index(2) rate_hz(4) trigger(1) signals(1)");
+        print_len("  0x02 data : Iq Id Uq Ud theta_e speed Vbus per sample, int16 each");
+        print_len("  0x03 end");
+    }
+
+    static void foc_scope(const int argc, char *argv[]) {
+        if (argc >= 2 && strcmp(argv[1], "--help") == 0) {
+            foc_scope_help();
+            return;
+        }
+        if (argc >= 2 && strcmp(argv[1], "arm") == 0) {
+            if (argc < 3) {
+                print_len("Missing trigger for scope arm");
+                return;
+            }
+            uint8_t trigger = 0;
+            while (trigger < Oscilloscope::TRIGGER_NUM && strcmp(argv[2], Oscilloscope::TRIGGER_NAMES[trigger]) != 0)
+                ++trigger;
+            if (trigger == Oscilloscope::TRIGGER_NUM) {
+                print_len(PROMPT_UNKNOW_TARGET(scope, argv[2]));
+                return;
+            }
+            const float level = argc >= 4 ? atof_lite(argv[3]) : 0.0f;
+            const auto pre = static_cast<uint16_t>(argc >= 5 ? atof_lite(argv[4]) : Oscilloscope::DEPTH / 4);
+            const auto decimation = static_cast<uint16_t>(argc >= 6 ? atof_lite(argv[5]) : 1);
+            Oscilloscope::arm(static_cast<Oscilloscope::Trigger>(trigger), level, pre, decimation);
+            print_len("Scope armed: trigger %s, level %.3g, pre %u, decimation %u",
+                      Oscilloscope::TRIGGER_NAMES[trigger], level,
+                      Oscilloscope::get_pre(), Oscilloscope::get_decimation());
+            return;
+        }
+        if (argc >= 2 && strcmp(argv[1], "force") == 0) {
+            Oscilloscope::force();
+            return;
+        }
+        if (argc >= 2 && strcmp(argv[1], "stop") == 0) {
+            Oscilloscope::stop();
+            print_len("Scope stopped");
+            return;
+        }
+        if (argc >= 2 && strcmp(argv[1], "dump") == 0) {
+            if (Oscilloscope::get_state() != Oscilloscope::STATE_DONE) {
+                print_len("No capture available");
+                return;
+            }
+            // 发送缓冲区满时重试,CDC发送完成后会腾出空间
+            const bool ok = Oscilloscope::dump([](uint8_t *data, const uint16_t len) {
+                for (uint8_t retry = 0; retry < 100; ++retry) {
+                    if (shellWrite(reinterpret_cast<char *>(data), len) == 0) return true;
+                    delay(1);
+                }
+                return false;
+            }, current_loop_frequency());
+            if (!ok) print_len("Scope dump failed");
+            return;
+        }
+
+        static constexpr const char *STATE_NAMES[] = {"idle", "armed", "triggered", "done"};
+        print_len("Scope status:");
+        print_len("  State      : %s", STATE_NAMES[Oscilloscope::get_state()]);
+        print_len("  Trigger    : %s, level %.3g", Oscilloscope::TRIGGER_NAMES[Oscilloscope::get_trigger()],
+                  Oscilloscope::get_level());
+        print_len("  Samples    : %u/%u, pre %u", Oscilloscope::get_filled(), Oscilloscope::DEPTH,
+                  Oscilloscope::get_pre());
+        print_len("  Sample rate: %u Hz", current_loop_frequency() / Oscilloscope::get_decimation());
+        if (Oscilloscope::CurrentStatistics stat{}; Oscilloscope::statistics(stat)) {
+            static constexpr const char *NAMES[] = {"Iu", "Iv", "Iq", "Id"};
+            print_len("  Current    : mean / std in mA, oversampling x%u", current_sensor.get_oversampling());
+            for (uint8_t k = 0; k < 4; ++k)
+                print_len("    %s       : %8.2f / %6.3f", NAMES[k], stat.mean[k] * 1e3f, stat.std[k] * 1e3f);
+        }
+    }
+
+    static void sys_tasks() {
+        static constexpr uint8_t MAX_TASKS = 10;
+        static constexpr const char *STATE_NAMES[] = {"running", "ready", "blocked", "suspended", "deleted", "invalid"}; // eTaskState
+        static TaskStatus_t status[MAX_TASKS]; // 放在静态区,避免占用shell任务栈
+        uint32_t total_runtime = 0;
+        const UBaseType_t num = uxTaskGetSystemState(status, MAX_TASKS, &total_runtime);
+        if (num == 0) {
+            print_len("Too many tasks, increase MAX_TASKS");
+            return;
+        }
+        std::sort(status, status + num, [](const TaskStatus_t& a, const TaskStatus_t& b) {
+            return a.xTaskNumber < b.xTaskNumber;
+        });
+
+        print_len("Tasks (CPU share since boot, ISR time is counted to the interrupted task):");
+        print_len("  %-16s %-9s %4s %7s %10s", "Name", "State", "Prio", "CPU", "Stack free");
+        for (UBaseType_t i = 0; i < num; ++i) {
+            const auto& task = status[i];
+            const float cpu = total_runtime ? 100.0f * static_cast<float>(task.ulRunTimeCounter) /
+                                              static_cast<float>(total_runtime) : 0.0f;
+            print_len("  %-16s %-9s %4u %6.1f%% %6u B", task.pcTaskName,
+                      STATE_NAMES[task.eCurrentState],
+                      static_cast<unsigned>(task.uxCurrentPriority), cpu,
+                      static_cast<unsigned>(task.usStackHighWaterMark * sizeof(StackType_t)));
+        }
+#if configSUPPORT_DYNAMIC_ALLOCATION
+        print_len("Heap: %u B free, %u B minimum ever free, %u B total",
+                  static_cast<unsigned>(xPortGetFreeHeapSize()),
+                  static_cast<unsigned>(xPortGetMinimumEverFreeHeapSize()),
+                  static_cast<unsigned>(configTOTAL_HEAP_SIZE));
+#else
+        print_len("Heap: none, static allocation only");
+#endif
+    }
+
     static void shell_reboot() {
         NVIC_SystemReset();
     }
@@ -291,6 +853,17 @@ public:
     }
 
 private:
+    // 实际电流环频率,倍频未能开启时仍为PWM频率
+    static uint32_t current_loop_frequency() {
+        return current_sensor.is_double_rate() ? 2 * FOC_PWM_FREQUENCY : FOC_PWM_FREQUENCY;
+    }
+
+    // 开启倍频允许的触发到退出电流环中断的最大耗时,单位CPU周期,与FOCTask中的判断一致
+    static uint32_t double_rate_budget() {
+        return static_cast<uint32_t>(static_cast<float>(SystemCoreClock / FOC_CURRENT_LOOP_FREQUENCY) *
+                                     FOC_DOUBLE_RATE_MAX_LOAD);
+    }
+
     static float atof_lite(const char *s) {
         if (!s) return 0.0f;
 
@@ -478,6 +1051,136 @@ private:
                 return qd4310.setLimit(std::nullopt, value);
             }
         },
+        {
+            "adc.oversampling", "Current ADC oversampling ratio (1/2/4/8/16)", nullptr, "%u",
+            [](const Item& self) {
+                print(self.format, current_sensor.get_oversampling());
+            },
+            [](const float value) {
+                if (qd4310.started) {
+                    print_len(PROMPT_DISABLE_FIRST);
+                    return false;
+                }
+                if (!current_sensor.set_oversampling(static_cast<uint8_t>(value))) {
+                    print_len("Invalid oversampling ratio: %d, must be 1, 2, 4, 8 or 16", static_cast<int>(value));
+                    return false;
+                }
+                return true;
+            }
+        },
+#if FOC_CURRENT_OFFSET_TRACK
+        {
+            "adc.offset_tau", "Current offset tracking time constant (>0.001)", "s", "%.3g",
+            [](const Item& self) {
+                print(self.format, current_offset_tracker.get_time_constant());
+            },
+            [](const float value) {
+                if (!current_offset_tracker.set_time_constant(value)) {
+                    print_len("Invalid time constant: %.3g, must be greater than 0.001", value);
+                    return false;
+                }
+                return true;
+            }
+        },
+#endif
+        {
+            "pwm.vbus_comp", "Normalize duty by bus voltage (0/1)", nullptr, "%u",
+            [](const Item& self) {
+                print(self.format, modulator.vbus_compensation);
+            },
+            [](const float value) {
+                if (value != 0 && value != 1) {
+                    print_len("Invalid value: %d, must be 0 or 1", static_cast<int>(value));
+                    return false;
+                }
+                modulator.vbus_compensation = value != 0;
+                return true;
+            }
+        },
+        {
+            "pwm.svpwm", "Modulation, 1 for SVPWM, 0 for SPWM (0/1)", nullptr, "%u",
+            [](const Item& self) {
+                print(self.format, modulator.modulation == BLDC_Modulator::Modulation::SVPWM);
+            },
+            [](const float value) {
+                if (value != 0 && value != 1) {
+                    print_len("Invalid value: %d, must be 0 or 1", static_cast<int>(value));
+                    return false;
+                }
+                modulator.modulation = value != 0 ? BLDC_Modulator::Modulation::SVPWM
+                                                  : BLDC_Modulator::Modulation::SPWM;
+                return true;
+            }
+        },
+        {
+            "pwm.overmod", "SVPWM max voltage utilization, 1 for linear, larger towards six-step (1-100)", nullptr, "%.3g",
+            [](const Item& self) {
+                print(self.format, modulator.get_max_utilization());
+            },
+            [](const float value) {
+                if (!modulator.set_max_utilization(value)) {
+                    print_len("Invalid utilization: %.3g, must be between 1 and 100", value);
+                    return false;
+                }
+                return true;
+            }
+        },
+        {
+            "pwm.deadtime", "Dead time to compensate, 0 to disable (0-2000)", "ns", "%.0f",
+            [](const Item& self) {
+                print(self.format, qd4310.getDeadTime() * 1e9f);
+            },
+            [](const float value) {
+                if (!qd4310.setDeadTime(value * 1e-9f)) {
+                    print_len("Invalid dead time: %.0f, must be between 0 and 2000", value);
+                    return false;
+                }
+                modulator.set_dead_time(qd4310.getDeadTime() * FOC_PWM_FREQUENCY, FOC_DEAD_TIME_BAND);
+                return true;
+            }
+        },
+        {
+            "fw.max_current", "Field weakening max negative Id, 0 to disable (0 to current limit)", "A", "%.3g",
+            [](const Item& self) {
+                print(self.format, field_weakening.get_max_current());
+            },
+            [](const float value) {
+                if (!field_weakening.set_max_current(value)) {
+                    print_len("Invalid current: %.3g, must be between 0 and %.3g", value,
+                              field_weakening.get_current_limit());
+                    return false;
+                }
+                return true;
+            }
+        },
+        {
+            "fw.threshold", "Voltage utilization to start field weakening (0.5-2)", nullptr, "%.3g",
+            [](const Item& self) {
+                print(self.format, field_weakening.get_threshold());
+            },
+            [](const float value) {
+                if (!field_weakening.set_threshold(value)) {
+                    print_len("Invalid threshold: %.3g, must be between 0.5 and 2", value);
+                    return false;
+                }
+                return true;
+            }
+        },
+#if FOC_SPEED_OBSERVER_PLL
+        {
+            "speed.pll_bw", "Speed PLL observer bandwidth (0-1000)", "Hz", "%.3g",
+            [](const Item& self) {
+                print(self.format, SpeedFilter.get_bandwidth());
+            },
+            [](const float value) {
+                if (!SpeedFilter.set_bandwidth(value)) {
+                    print_len("Invalid bandwidth: %.3g, must be between 0 and 1000", value);
+                    return false;
+                }
+                return true;
+            }
+        },
+#endif
         {
             "can.id", "CAN ID of the motor (0-7)", nullptr, "%03u",
             [](const Item& self) {
@@ -575,6 +1278,13 @@ private:
                 return true;
             }
         },
+        {
+            "position", "Set multi-turn position", "rad", "%.3g",
+            nullptr,
+            [](const float value) {
+                return qd4310.CtrlPosition(QD4310::radian_to_position(value));
+            }
+        },
     };
 };
 
@@ -626,3 +1336,15 @@ SHELL_EXPORT_CMD(
     SHELL_CMD_DISABLE_RETURN|SHELL_CMD_PERMISSION(0)|SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN),
     info, ShellPlugs::foc_info, Show hardware information
 );
+SHELL_EXPORT_CMD(
+    SHELL_CMD_DISABLE_RETURN|SHELL_CMD_PERMISSION(0)|SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN),
+    perf, ShellPlugs::foc_perf, Show current loop ISR timing
+);
+SHELL_EXPORT_CMD(
+    SHELL_CMD_DISABLE_RETURN|SHELL_CMD_PERMISSION(0)|SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN),
+    scope, ShellPlugs::foc_scope, Capture current loop waveforms
+);
+SHELL_EXPORT_CMD(
+    SHELL_CMD_DISABLE_RETURN|SHELL_CMD_PERMISSION(0)|SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN),
+    tasks, ShellPlugs::sys_tasks, Show task CPU usage stack and heap
+);
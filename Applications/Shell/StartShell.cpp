@@ -3,8 +3,8 @@
  * @brief       启动shell
  * @details
  * @author      Liu-Curiousity (2675794963@qq.com)
- * @date        2026-5-14
- * @version     V1.1.2
+ * @date        2026-10-17
+ * @version     V1.2.0
  * @note
  * @warning
  * @par         历史版本:
@@ -12,9 +12,12 @@
  *		        V1.1.0创建于2025-7-8
  *		        V1.1.1创建于2026-5-6, 使用sizeof()替换定值shell缓冲区大小, 减少误设置风险
  *		        V1.1.2创建于2026-5-14, 增大LetterShell任务的栈空间分配
+ *		        V1.2.0创建于2026-10-17, LetterShell任务改为静态创建
  * @copyright   (c) 2026 QDrive
  */
 
+#include <iterator>
+
 #include "task_public.h"
 #include "usbd_cdc_if.h"
 #include "usb_device.h"
@@ -26,6 +29,9 @@
 Shell shell;
 char shellBuffer[256];
 
+static StackType_t shellTaskStack[512];   // LetterShell任务栈
+static StaticTask_t shellTaskControlBlock; // LetterShell任务控制块
+
 void USB_Disconnected() {
     __HAL_RCC_USB_FORCE_RESET();
     delay_ms(200);
@@ -52,6 +58,7 @@ void StartStartShell(void *argument) {
     shell.read = shellRead;
     shell.write = shellWrite;
     shellInit(&shell, shellBuffer, sizeof(shellBuffer));
-    xTaskCreate(shellTask, "LetterShellTask", 512, &shell, osPriorityNormal, nullptr);
+    xTaskCreateStatic(shellTask, "LetterShellTask", std::size(shellTaskStack), &shell, osPriorityNormal,
+                      shellTaskStack, &shellTaskControlBlock);
     vTaskDelete(nullptr);
 }
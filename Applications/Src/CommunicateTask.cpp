@@ -3,8 +3,8 @@
  * @brief       通信任务
  * @details
  * @author      Liu-Curiousity (2675794963@qq.com)
- * @date        2026-7-2
- * @version     V1.4.0
+ * @date        2026-10-17
+ * @version     V1.8.0
  * @note
  * @warning
  * @par         历史版本:
@@ -19,6 +19,11 @@
  *		        V1.3.0创建于2026-5-14, 添加通过Uart/Can设置零点和重启设备
  *		        V1.4.0创建于2026-7-2, 收到重启命令后先发送反馈报文再执行重启
  *		                             反馈报文添加控制状态反馈和错误码反馈
+ *		        V1.5.0创建于2026-10-17, 实现清除错误指令,用于清除控制周期超时警告
+ *		        V1.5.1创建于2026-10-17, 指令队列改为静态创建
+ *		        V1.6.0创建于2026-10-17, CRC8移至CRC8.h,通信帧校验改用编译期生成的查找表
+ *		        V1.7.0创建于2026-10-17, 通信帧校验改用Crc8Engine,固件中由硬件CRC单元计算
+ *		        V1.8.0创建于2026-10-17, 添加多圈角度控制和多圈位置读取指令,以多圈反馈报文应答
  * @copyright   (c) 2026 QDrive
  */
 
@@ -28,6 +33,7 @@
 #include "fdcan.h"
 #include "usart.h"
 #include "QD4310.h"
+#include "Crc8Engine.h"
 #include <numbers>
 
 #include "FreeRTOS.h"
@@ -52,6 +58,8 @@ public:
         AngleCtrl = 0x05,     // 角度控制
         LowSpeedCtrl = 0x06,  // 低速控制
         StepAngleCtrl = 0x07, // 角度步进控制
+        PositionCtrl = 0x08,  // 多圈角度控制,控制量为int32
+        GetPosition = 0x09,   // 读取多圈位置
 
         Reboot = 0xFF,     // 重启
         SetZeroPos = 0xFE, // 设置零点
@@ -68,6 +76,8 @@ public:
             case CmdType::AngleCtrl:
             case CmdType::LowSpeedCtrl:
             case CmdType::StepAngleCtrl:
+            case CmdType::PositionCtrl:
+            case CmdType::GetPosition:
             case CmdType::Reboot:
             case CmdType::SetZeroPos:
             case CmdType::ClearError:
@@ -77,12 +87,24 @@ public:
         }
     }
 
+    /**
+     * @brief 指令数据长度(不含指令类型),PositionCtrl为4字节,其余为2字节
+     */
+    static uint8_t data_length(const CmdType cmd) {
+        return cmd == CmdType::PositionCtrl ? sizeof(int32_t) : sizeof(int16_t);
+    }
+
     union RxData {
         struct __attribute__((packed)) {
             CmdType cmd_type; // 命令类型
             int16_t data;     // 命令数据
         } fields;
 
+        struct __attribute__((packed)) {
+            CmdType cmd_type; // 命令类型
+            int32_t data;     // 多圈位置,单位2^-16圈
+        } position_fields;
+
         uint8_t raw[8]; // 原始数据
     } rx_data{};
 
@@ -93,27 +115,46 @@ union TxData {
     struct __attribute__((packed)) {
         uint8_t id;          // 电机ID
         uint8_t motor_state; // 电机状态
-        uint8_t error_code;  // 错误码(预留)
+        uint8_t error_code;  // 错误码
         int16_t current;     // Q轴电流
         int16_t speed;       // 电机转速
         int16_t angle;       // 电机角度
         uint8_t crc8;        // CRC8校验
     } data;
 
+    struct __attribute__((packed)) {
+        uint8_t id;          // 电机ID
+        uint8_t motor_state; // 电机状态
+        uint8_t error_code;  // 错误码
+        int16_t speed;       // 电机转速
+        int32_t position;    // 多圈位置,单位2^-16圈
+        uint8_t crc8;        // CRC8校验
+    } position_data;
+
     uint8_t raw[10]; // 原始数据
 };
 
+static_assert(sizeof(TxData::data) == sizeof(TxData::raw) && sizeof(TxData::position_data) == sizeof(TxData::raw));
+
+/**
+ * @brief 多圈位置(单位2^-32圈)转为通信中的int32(单位2^-16圈),超出±32768圈时饱和
+ */
+static int32_t position_to_frame(const int64_t position) {
+    return static_cast<int32_t>(std::clamp<int64_t>(position >> 16, INT32_MIN, INT32_MAX));
+}
+
 extern QD4310 qd4310;
 uint8_t UART_RxBuffer[sizeof(RxCommand::rx_data) + 2]; // UART接收缓冲区
 void FDCAN_Filter_INIT(FDCAN_HandleTypeDef *hfdcan);
-void CAN_Transmit(uint8_t length, uint8_t *pdata);
-uint8_t CRC8(const uint8_t *data, uint32_t len, uint8_t polynomial, uint8_t init,
-             uint8_t xor_out, bool input_invert, bool output_invert);
+void CAN_Transmit(uint8_t length, uint8_t *pdata, uint32_t base_id = 0x500);
 
 xQueueHandle xQueue1;
+static StaticQueue_t xQueue1ControlBlock;               // 指令队列控制块
+static uint8_t xQueue1Storage[5 * sizeof(RxCommand)]; // 指令队列存储区
 
 void StartCommunicateTask(void *argument) {
-    xQueue1 = xQueueCreate(5, sizeof(RxCommand));
+    xQueue1 = xQueueCreateStatic(5, sizeof(RxCommand), xQueue1Storage, &xQueue1ControlBlock);
+    Crc8Engine::init();
     // 1.等待foc启动
     while (!qd4310.enabled)
         delay(10);
@@ -170,12 +211,22 @@ void StartCommunicateTask(void *argument) {
                     rx_command.rx_data.fields.data * 2 * numbers::pi_v<float> / INT16_MAX
                 });
                 break;
+            case RxCommand::CmdType::PositionCtrl: // 多圈角度控制
+                status = qd4310.CtrlPosition(static_cast<int64_t>(rx_command.rx_data.position_fields.data) << 16);
+                break;
+            case RxCommand::CmdType::GetPosition: // 读取多圈位置,只发送多圈反馈报文
+                status = true;
+                break;
             case RxCommand::CmdType::Reboot: // 重启
                 status = true;
                 break;
             case RxCommand::CmdType::SetZeroPos: // 设置零点
                 status = qd4310.setZeroPosition();
                 break;
+            case RxCommand::CmdType::ClearError: // 清除错误
+                qd4310.clearError();
+                status = true;
+                break;
             default:
                 status = false;
                 break;
@@ -185,13 +236,21 @@ void StartCommunicateTask(void *argument) {
         tx_data.data.motor_state = qd4310.started | status << 1 |
                                    static_cast<uint8_t>(qd4310.getCtrlType().type) << 4;  // 电机状态
         tx_data.data.error_code = qd4310.error_code;                                      // 错误码
-        tx_data.data.current = qd4310.getCurrent() / 10 * INT16_MAX;                      // Q轴电流
-        tx_data.data.speed = qd4310.getSpeed() / 1000 * INT16_MAX;                        // 电机转速
-        tx_data.data.angle = qd4310.getAngle() / (2 * numbers::pi_v<float>) * UINT16_MAX; // 电机角度
-        tx_data.data.crc8 = CRC8(tx_data.raw, sizeof(tx_data.raw) - 1, 0x07, 0x00, 0x00, false, false);
+        // 多圈指令以多圈反馈报文应答
+        const bool position_frame = rx_command.rx_data.fields.cmd_type == RxCommand::CmdType::PositionCtrl ||
+                                    rx_command.rx_data.fields.cmd_type == RxCommand::CmdType::GetPosition;
+        if (position_frame) {
+            tx_data.position_data.speed = qd4310.getSpeed() / 1000 * INT16_MAX;          // 电机转速
+            tx_data.position_data.position = position_to_frame(qd4310.getPosition());    // 多圈位置
+        } else {
+            tx_data.data.current = qd4310.getCurrent() / 10 * INT16_MAX;                      // Q轴电流
+            tx_data.data.speed = qd4310.getSpeed() / 1000 * INT16_MAX;                        // 电机转速
+            tx_data.data.angle = qd4310.getAngle() / (2 * numbers::pi_v<float>) * UINT16_MAX; // 电机角度
+        }
+        tx_data.data.crc8 = Crc8Engine::compute(tx_data.raw, sizeof(tx_data.raw) - 1);
         // 根据不同的接口类型发送反馈报文
         if (rx_command.plug == RxCommand::PlugType::CAN) {
-            CAN_Transmit(sizeof(tx_data.raw) - 2, tx_data.raw + 1);
+            CAN_Transmit(sizeof(tx_data.raw) - 2, tx_data.raw + 1, position_frame ? 0x580 : 0x500);
         } else if (rx_command.plug == RxCommand::PlugType::UART) {
             HAL_UART_Transmit_DMA(&huart3, tx_data.raw, sizeof(tx_data.raw));
         } else if (rx_command.plug == RxCommand::PlugType::PWM) {} else {}
@@ -233,8 +292,10 @@ void HAL_FDCAN_RxFifo0Callback(FDCAN_HandleTypeDef *hfdcan, uint32_t RxFifo0ITs)
         if (HAL_FDCAN_GetRxFifoFillLevel(hfdcan, FDCAN_RX_FIFO0)) {
             /*读取数据*/
             HAL_FDCAN_GetRxMessage(hfdcan, FDCAN_RX_FIFO0, &RxHeader, rx_command.rx_data.raw);
-            // 如果是自己ID的报文且数据长度匹配,进行处理
-            if (RxHeader.Identifier == 0x400 + qd4310.ID && RxHeader.DataLength == 3) {
+            // 如果是自己ID的报文且数据长度与指令类型匹配,进行处理
+            const auto cmd_type = static_cast<RxCommand::CmdType>(rx_command.rx_data.raw[0]);
+            if (RxHeader.Identifier == 0x400 + qd4310.ID &&
+                RxHeader.DataLength == 1u + RxCommand::data_length(cmd_type)) {
                 xQueueSendToBackFromISR(xQueue1, &rx_command, &xHigherPriorityTaskWoken);
                 portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
             }
@@ -249,11 +310,12 @@ void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size) {
     BaseType_t xHigherPriorityTaskWoken;
     if (huart->Instance == huart3.Instance) {
         static RxCommand rx_command{.rx_data = {}, .plug = RxCommand::PlugType::UART};
-        // 如果是自己ID的报文、数据长度匹配且CRC8校验通过,进行处理
-        // id:1 byte, cmd:1 byte, data:2 bytes, crc8:1 byte
-        if (UART_RxBuffer[0] == qd4310.ID && Size == 5 &&
-            CRC8(UART_RxBuffer, 4, 0x07, 0x00, 0x00, false, false) == UART_RxBuffer[4]) {
-            std::copy_n(UART_RxBuffer + 1, 3, rx_command.rx_data.raw);
+        // 如果是自己ID的报文、数据长度与指令类型匹配且CRC8校验通过,进行处理
+        // id:1 byte, cmd:1 byte, data:2 bytes(PositionCtrl为4 bytes), crc8:1 byte
+        const uint16_t length = 3 + RxCommand::data_length(static_cast<RxCommand::CmdType>(UART_RxBuffer[1]));
+        if (UART_RxBuffer[0] == qd4310.ID && Size == length &&
+            Crc8Engine::compute(UART_RxBuffer, length - 1) == UART_RxBuffer[length - 1]) {
+            std::copy_n(UART_RxBuffer + 1, length - 2, rx_command.rx_data.raw);
             xQueueSendToBackFromISR(xQueue1, &rx_command, &xHigherPriorityTaskWoken);
             portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
         }
@@ -271,45 +333,14 @@ void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart) {
     }
 }
 
-void CAN_Transmit(uint8_t length, uint8_t *pdata) {
+void CAN_Transmit(uint8_t length, uint8_t *pdata, const uint32_t base_id) {
     /*定义CAN数据包头*/
     static FDCAN_TxHeaderTypeDef TxHeader = {
         0x500, FDCAN_STANDARD_ID, FDCAN_DATA_FRAME, FDCAN_DLC_BYTES_8, FDCAN_ESI_ACTIVE,
         FDCAN_BRS_OFF,FDCAN_CLASSIC_CAN, FDCAN_NO_TX_EVENTS, 0
     };
-    TxHeader.Identifier = 0x500 + qd4310.ID;
+    TxHeader.Identifier = base_id + qd4310.ID;
     TxHeader.DataLength = length;
     HAL_FDCAN_AddMessageToTxFifoQ(&hfdcan1, &TxHeader, pdata);
 }
 
-
-/**
- * @brief 反转字节(按bit反转)
- * */
-static uint8_t ReverseBits(uint8_t data) {
-    data = ((data & 0x55) << 1) | ((data & 0xAA) >> 1);
-    data = ((data & 0x33) << 2) | ((data & 0xCC) >> 2);
-    data = ((data & 0x0F) << 4) | ((data & 0xF0) >> 4);
-    return data;
-}
-
-uint8_t CRC8(const uint8_t *data, uint32_t len, uint8_t polynomial, uint8_t init,
-             uint8_t xor_out, bool input_invert, bool output_invert) {
-    /**1.校验参数**/
-    assert_param(data != nullptr);
-    assert_param(len > 0);
-    /**2.变量定义**/
-    uint8_t crc = init;
-    /**3.计算**/
-    do {
-        crc ^= input_invert ? ReverseBits(*(data++)) : *(data++);
-        for (uint8_t i = 0; i < 8; ++i) {
-            if (crc & 0x80) {
-                crc = (crc << 1) ^ polynomial;
-            } else {
-                crc <<= 1;
-            }
-        }
-    } while (--len);
-    return output_invert ? ReverseBits(crc ^ xor_out) : (crc ^ xor_out);
-}
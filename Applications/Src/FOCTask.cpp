@@ -3,8 +3,8 @@
  * @brief       FOC控制任务
  * @details
  * @author      Liu-Curiousity (2675794963@qq.com)
- * @date        2026-6-14
- * @version     V1.1.3
+ * @date        2026-10-17
+ * @version     V1.18.2
  * @note
  * @warning
  * @par         历史版本:
@@ -14,9 +14,34 @@
  *		        V1.1.1创建于2025-5-4, 优化ADC采样方式
  *		        V1.1.2创建于2025-12-27, 适配QD4310重构
  *		        V1.1.3创建于2026-6-14, 适配PID重构
+ *		        V1.2.0创建于2026-10-17, 添加电流环中断分阶段耗时统计
+ *		        V1.3.0创建于2026-10-17, 添加电流环频率的示波器记录
+ *		        V1.4.0创建于2026-10-17, 添加控制中断超时监测
+ *		        V1.5.0创建于2026-10-17, 编码器改为由ADC注入触发同一时刻(TIM1 CC4)启动的SPI DMA读取
+ *		        V1.6.0创建于2026-10-17, 上报编码器错误帧警告
+ *		        V1.7.0创建于2026-10-17, 编码器角度按实测的采样到PWM生效延迟外推补偿
+ *		        V1.8.0创建于2026-10-17, 可选PLL速度观测器替代差分低通
+ *		        V1.9.0创建于2026-10-17, 电流采样开启注入组硬件过采样
+ *		        V1.10.0创建于2026-10-17, 可选三电阻采样,按占空比选择采样相
+ *		        V1.11.0创建于2026-10-17, 电机停止且静止时跟踪电流采样零点漂移
+ *		        V1.12.0创建于2026-10-17, 可选母线电压由PWM触发DMA采样,每个电流环周期更新
+ *		        V1.13.0创建于2026-10-17, 占空比经调制级按实时母线电压归一化
+ *		        V1.14.0创建于2026-10-17, 调制级可选SVPWM(min-max零序注入)
+ *		        V1.15.0创建于2026-10-17, 电压饱和时弱磁,调制级可选过调制
+ *		        V1.16.0创建于2026-10-17, 调制级按相电流极性补偿死区
+ *		        V1.17.0创建于2026-10-17, 可选电流环倍频(PWM波峰波谷各采样一次),实测中断耗时满足预算后开启
+ *		        V1.17.1创建于2026-10-17, 电流环中断开头调用DWT_Profiler::begin()
+ *		        V1.17.2创建于2026-10-17, 母线电压归一化默认关闭,运行时可开启
+ *		        V1.17.3创建于2026-10-17, 弱磁电流从Q轴电流限幅中扣除,弱磁电流上限为FOC_MAX_CURRENT
+ *		        V1.17.4创建于2026-10-17, 电流环倍频需在线电流采样,QD4310下桥采样电阻编译期拒绝
+ *		        V1.18.0创建于2026-10-17, 编码器读取方式由FOC_ENCODER_DMA决定,默认HAL;DMA未触发或超时时上报编码器警告
+ *		        V1.18.1创建于2026-10-17, 调制级直接输出整数比较值到bldc_driver.set_compare()
+ *		        V1.18.2创建于2026-10-17, 调制级相电流滤波按电流环周期计算,电流环叠加QD4310注入的D轴电流
  * @copyright   (c) 2026 QDrive
  */
 
+#include <cmath>
+#include <numbers>
 #include "task_public.h"
 #include "FreeRTOS.h"
 #include "QDrive.h"
@@ -26,29 +51,56 @@
 #include "adc.h"
 #include "cmsis_os2.h"
 #include "Encoder_MT6826S.h"
+#include "Encoder_Compensated.h"
 #include "BLDC_Driver_DRV8300.h"
+#include "BLDC_Modulator.h"
+#include "FieldWeakening.h"
 #include "Storage_EmbeddedFlash.h"
 #include "CurrentSensor_Embed.h"
+#include "CurrentOffsetTracker.h"
+#include "VoltageSensor_Embed.h"
 #include "filters.h"
+#include "PLL_SpeedObserver.h"
 #include "QD4310.h"
+#include "DWT_Profiler.h"
+#include "Oscilloscope.h"
+#include "DeadlineMonitor.h"
 #include "task.h"
 
+constexpr float CURRENT_LOOP_PERIOD = 1.0f / FOC_CURRENT_LOOP_FREQUENCY; // 电流环周期,单位s
+
 BLDC_Driver_DRV8300 bldc_driver(&htim1, 2125);
-Encoder_MT6826S bldc_encoder(SPI1_CSn_GPIO_Port, SPI1_CSn_Pin, &hspi1);
-CurrentSensor_Embed current_sensor(&hadc1, &hadc2);
+BLDC_Modulator modulator(bldc_driver, FOC_NOMINAL_VOLTAGE, FOC_ABSOLUTE_MIN_VOLTAGE, FOC_ABSOLUTE_MAX_VOLTAGE,
+                         CURRENT_LOOP_PERIOD);
+FieldWeakening field_weakening(CURRENT_LOOP_PERIOD, FOC_FW_GAIN, FOC_FW_MAX_CURRENT, FOC_FW_THRESHOLD,
+                               FOC_MAX_CURRENT);
+Encoder_MT6826S bldc_encoder(SPI1_CSn_GPIO_Port, SPI1_CSn_Pin, &hspi1, DMA1_Channel3, DMA1_Channel4);
+Encoder_Compensated compensated_encoder(bldc_encoder, 0.00005f); // 初值为1个PWM周期,运行后由实测值校准
+CurrentSensor_Embed current_sensor(&hadc1, &hadc2, FOC_CURRENT_OVERSAMPLING);
+constexpr float VBUS_SCALE = 3.3f / 4095 / 2 * 17; // 母线电压ADC读数到电压,单位V/LSB
+#if FOC_VBUS_DMA
+VoltageSensor_Embed voltage_sensor(&hadc1, VBUS_SCALE);
+#endif
+#if FOC_CURRENT_OFFSET_TRACK
+CurrentOffsetTracker current_offset_tracker(current_sensor, 0.001f, FOC_CURRENT_OFFSET_TAU); // 1kHz
+#endif
 
-LowPassFilter_2_Order CurrentQFilter(0.00005f, 1500); // 20kHz
-LowPassFilter_2_Order CurrentDFilter(0.00005f, 1500); // 20kHz
-LowPassFilter_2_Order SpeedFilter(0.00005f, 300);     // 20kHz
+LowPassFilter_2_Order CurrentQFilter(CURRENT_LOOP_PERIOD, 1500);
+LowPassFilter_2_Order CurrentDFilter(CURRENT_LOOP_PERIOD, 1500);
+#if FOC_SPEED_OBSERVER_PLL
+PLL_SpeedObserver SpeedFilter(CURRENT_LOOP_PERIOD, FOC_SPEED_PLL_BANDWIDTH);
+#else
+LowPassFilter_2_Order SpeedFilter(CURRENT_LOOP_PERIOD, 300);
+#endif
 
-QD4310 qd4310(FOC_POLE_PAIRS, 5000, 20000,
+QD4310 qd4310(FOC_POLE_PAIRS, 5000, FOC_CURRENT_LOOP_FREQUENCY,
               CurrentQFilter, CurrentDFilter, SpeedFilter,
-              bldc_driver, bldc_encoder, storage, current_sensor,
+              modulator, compensated_encoder, storage, current_sensor,
               PID(PID::delta_type,
                   FOC_CURRENT_KP,
                   FOC_CURRENT_KI,
                   FOC_CURRENT_KD,
-                  0.00005f, // 20kHz
+                  CURRENT_LOOP_PERIOD,
                   nullopt,
                   nullopt,
                   1.0f,
@@ -58,7 +110,7 @@ QD4310 qd4310(FOC_POLE_PAIRS, 5000, 20000,
                   FOC_CURRENT_KP,
                   FOC_CURRENT_KI,
                   FOC_CURRENT_KD,
-                  0.00005f, // 20kHz
+                  CURRENT_LOOP_PERIOD,
                   nullopt,
                   nullopt,
                   1.0f,
@@ -87,33 +139,193 @@ QD4310 qd4310(FOC_POLE_PAIRS, 5000, 20000,
 );
 
 QDrive& qdrive = *reinterpret_cast<QDrive *>(&qd4310);
+uint32_t double_rate_busy = 0; // 开启倍频前实测的触发到退出电流环中断的最大耗时,单位CPU周期
 
 void StartFOCTask(void *argument) {
+    DWT_Profiler::init(SystemCoreClock / FOC_CURRENT_LOOP_FREQUENCY); // 电流环每周期可用的CPU周期数
+    // 上电时只在PWM波谷触发,倍频在实测中断耗时后开启
+    DeadlineMonitor::init(DeadlineMonitor::CHANNEL_CURRENT_LOOP, SystemCoreClock / FOC_PWM_FREQUENCY);
+    DeadlineMonitor::init(DeadlineMonitor::CHANNEL_CTRL_LOOP, SystemCoreClock / 5000);
+    uint32_t deadline_violations = 0;
+    uint32_t encoder_errors = 0;
+    // TIM1 CC4与ADC注入触发(OC4REF)同时发生,由其DMA请求启动编码器SPI读取,电流与角度同时采样
+    bldc_encoder.attach_trigger(DMA1_Channel5, DMA_REQUEST_TIM1_CH4);
+    bldc_encoder.read_path = FOC_ENCODER_DMA ? SPI_ReadPath::DMA : SPI_ReadPath::HAL;
+    // 过采样窗口以原触发点为中心,编码器读取随之提前,角度补偿延迟由CCR4实测
+    current_sensor.attach_trigger(&htim1, TIM_CHANNEL_4);
+#if FOC_CURRENT_THREE_SHUNT
+    current_sensor.enable_three_shunt(FOC_CURRENT_W_CHANNEL, FOC_CURRENT_W_INVERTED);
+#endif
+    compensated_encoder.set_speed_source([] {
+        return qd4310.getSpeed() * (2 * std::numbers::pi_v<float> / 60); // rpm转rad/s
+    });
+    // 母线电压来源始终设置,是否归一化由vbus_compensation决定,可用config pwm.vbus_comp切换
+    modulator.set_voltage_source([] { return qd4310.getVoltage(); });
+    modulator.vbus_compensation = FOC_VBUS_COMPENSATION;
+    modulator.modulation = FOC_MODULATION_SVPWM ? BLDC_Modulator::Modulation::SVPWM
+                                                : BLDC_Modulator::Modulation::SPWM;
+    modulator.set_max_utilization(FOC_OVERMODULATION);
+    modulator.set_compare_output([](const uint32_t u, const uint32_t v, const uint32_t w) {
+        bldc_driver.set_compare(u, v, w);
+    }, bldc_driver.get_max_duty());
+    __HAL_TIM_ENABLE_DMA(&htim1, TIM_DMA_CC4);
     HAL_TIM_Base_Start_IT(&htim6);            // 开启速度环位置环中断控制
     HAL_TIM_PWM_Start(&htim1, TIM_CHANNEL_4); //开启PWM输出,用于触发ADC采样
     qd4310.init();                            // 初始化FOC
+    modulator.set_dead_time(qd4310.getDeadTime() * FOC_PWM_FREQUENCY, FOC_DEAD_TIME_BAND);
     qd4310.enable();                          // 使能FOC
+#if FOC_VBUS_DMA
+    // 规则组与注入组同由TRGO2触发,注入转换后紧接着转换母线电压,电流环中断中读取
+    voltage_sensor.start(DMA1_Channel6, LL_ADC_REG_TRIG_EXT_TIM1_TRGO2);
+    delay(1); // 等待缓冲区填满,避免错误检测读到0V
+#endif
+#if FOC_CURRENT_DOUBLE_RATE
+    // 以单倍频运行一段时间,触发到退出中断的最大耗时不超过半个PWM周期的FOC_DOUBLE_RATE_MAX_LOAD时开启倍频;
+    // 控制参数按倍频编译,未能开启时上报RateError禁止启动;仅在线电流采样硬件可编译此分支(见QDrive_cfg.h)
+    delay(FOC_DOUBLE_RATE_PROFILE_MS);
+    const auto profile = DeadlineMonitor::snapshot(DeadlineMonitor::CHANNEL_CURRENT_LOOP);
+    double_rate_busy = profile.max_busy;
+    if (profile.count > 0 &&
+        static_cast<float>(profile.max_busy) <=
+        static_cast<float>(SystemCoreClock / FOC_CURRENT_LOOP_FREQUENCY) * FOC_DOUBLE_RATE_MAX_LOAD &&
+        current_sensor.set_double_rate(true)) {
+        DWT_Profiler::reset();
+        DeadlineMonitor::init(DeadlineMonitor::CHANNEL_CURRENT_LOOP, SystemCoreClock / FOC_CURRENT_LOOP_FREQUENCY);
+    } else {
+        qd4310.reportRateError();
+    }
+    deadline_violations = DeadlineMonitor::violations();
+#endif
     while (true) {
+#if !FOC_VBUS_DMA
         if (!LL_ADC_REG_IsConversionOngoing(hadc1.Instance)) {
-            qd4310.updateVoltage(hadc1.Instance->DR / 4095.0f * 3.3f / 2 * 17);
+            qd4310.updateVoltage(static_cast<float>(hadc1.Instance->DR) * VBUS_SCALE);
             LL_ADC_REG_StartConversion(hadc1.Instance);
         }
+#endif
+        // 有新的控制中断超时则上报警告
+        if (const uint32_t violations = DeadlineMonitor::violations(); violations != deadline_violations) {
+            deadline_violations = violations;
+            qd4310.reportOverrun();
+        }
+        // 有新的编码器错误帧,或DMA读取未触发、超时而改为阻塞读取,则上报警告
+        if (const uint32_t errors = bldc_encoder.frame_errors() + bldc_encoder.dma_misses(); errors != encoder_errors) {
+            encoder_errors = errors;
+            qd4310.reportEncoderError();
+        }
         qd4310.error_detect();
+#if FOC_CURRENT_OFFSET_TRACK
+        // 未启动、未校准且转子静止时相电流为0,读数即为零点漂移
+        constexpr float STILL_SPEED = 5.0f; // 单位rpm
+        current_offset_tracker.update(!qd4310.started && !qd4310.isCalibrating() &&
+                                      std::abs(qd4310.getSpeed()) < STILL_SPEED);
+#endif
         delay(1);
     }
 }
 
+/**
+ * @brief 由TIM1计数值换算ADC注入触发到当前的CPU周期数
+ * @param peak 本次为波峰触发
+ * @note TIM1中心对齐计数,TRGO2为OC4REF(PWM1模式),即向下计数经过CCR4时触发;
+ *       倍频时波峰触发为OC6REF(PWM2模式),即向上计数经过CCR6时触发
+ */
+__attribute__((section(".ccmram_func")))
+static uint32_t current_loop_latency(const bool peak) {
+    const TIM_TypeDef *tim = htim1.Instance;
+    const uint32_t cnt = tim->CNT, arr = tim->ARR;
+    uint32_t ticks;
+    if (peak) {
+        const uint32_t ccr6 = tim->CCR6;
+        if (tim->CR1 & TIM_CR1_DIR) ticks = 2 * arr - ccr6 - cnt;                            // 向下计数
+        else ticks = cnt - ccr6;                                                             // 向上计数
+    } else {
+        const uint32_t ccr4 = tim->CCR4;
+        if (tim->CR1 & TIM_CR1_DIR) ticks = cnt <= ccr4 ? ccr4 - cnt : 2 * arr + ccr4 - cnt; // 向下计数
+        else ticks = ccr4 + cnt;                                                             // 向上计数
+    }
+    return ticks * (tim->PSC + 1);
+}
+
+/**
+ * @brief 由TIM1计数值换算当前到新占空比生效窗口中点的CPU周期数
+ * @param double_rate 电流环倍频
+ * @note CCR预装载在每次更新事件(中心对齐,上溢和下溢)载入,新占空比在下一次更新事件载入后
+ *       生效一个PWM周期(2*ARR个计数),窗口中点再往后ARR个计数;
+ *       倍频时下一个半周期就被新的占空比覆盖,窗口中点往后ARR/2个计数
+ */
+__attribute__((section(".ccmram_func")))
+static uint32_t apply_delay(const bool double_rate) {
+    const TIM_TypeDef *tim = htim1.Instance;
+    const uint32_t cnt = tim->CNT, arr = tim->ARR;
+    const uint32_t ticks = tim->CR1 & TIM_CR1_DIR ? cnt : arr - cnt; // 到下一次更新事件
+    return (ticks + (double_rate ? arr / 2 : arr)) * (tim->PSC + 1);
+}
+
 __attribute__((section(".ccmram_func")))
 void HAL_ADCEx_InjectedConvCpltCallback(ADC_HandleTypeDef *hadc) {
     if (&hadc1 == hadc) {
+        // 波峰触发后的中断在计数值上半段进入(中断延迟小于四分之一个PWM周期)
+        const bool double_rate = current_sensor.is_double_rate();
+        const bool peak = double_rate && htim1.Instance->CNT > htim1.Instance->ARR / 2;
+        const uint32_t latency = current_loop_latency(peak);
+        DeadlineMonitor::enter(DeadlineMonitor::CHANNEL_CURRENT_LOOP, latency);
+        DWT_Profiler::begin();
+        const uint32_t start = DWT_Profiler::now();
         current_sensor.update();
+#if FOC_VBUS_DMA
+        if (voltage_sensor.is_started()) qd4310.updateVoltage(voltage_sensor.voltage());
+#endif
+        DWT_Profiler::mark(DWT_Profiler::STAGE_CURRENT_SENSE, DWT_Profiler::now() - start);
+        modulator.update_current(current_sensor.iu, current_sensor.iv, current_sensor.iw);
+        field_weakening.apply(current_sensor, qd4310.getElectricAngle(), qd4310.getInjectedCurrentD());
+        // 波峰触发不产生CC4 DMA请求,编码器没有新读数,由波谷读数外推半个PWM周期
+        if (peak) compensated_encoder.extrapolate_next(0.5f / FOC_PWM_FREQUENCY);
         qd4310.loopCtrl();
+        field_weakening.restore(current_sensor);
+        if (qd4310.started) field_weakening.update(modulator.get_utilization());
+        else field_weakening.reset();
+#if FOC_CURRENT_THREE_SHUNT
+        // 按新占空比选择下一周期的采样相,与bldc_driver的通道映射一致(U:CH1,V:CH3,W:CH2)
+        current_sensor.select_phases(htim1.Instance->CCR1, htim1.Instance->CCR3, htim1.Instance->CCR2);
+#endif
+        bldc_encoder.arm(); // 装填下一周期的编码器DMA读取,波峰时DMA尚未触发,不重复装填
+        // 采样(ADC注入触发,编码器DMA同时启动)到占空比写入由DWT计时,再加上到PWM生效窗口中点的时间
+        compensated_encoder.calibrate(static_cast<float>(latency + (DWT_Profiler::now() - start) +
+                                                         apply_delay(double_rate)) /
+                                      static_cast<float>(SystemCoreClock));
+        if (Oscilloscope::is_recording()) {
+            constexpr float DUTY_SCALE = 1.0f / 2125; // 与bldc_driver的MaxDuty一致
+            Oscilloscope::record(
+                {
+                    .iu = Oscilloscope::to_current(current_sensor.iu),
+                    .iv = Oscilloscope::to_current(current_sensor.iv),
+                    .theta_e = Oscilloscope::to_angle(qd4310.getElectricAngle()),
+                    .duty_u = Oscilloscope::to_duty(static_cast<float>(htim1.Instance->CCR1) * DUTY_SCALE),
+                    .duty_v = Oscilloscope::to_duty(static_cast<float>(htim1.Instance->CCR3) * DUTY_SCALE),
+                    .duty_w = Oscilloscope::to_duty(static_cast<float>(htim1.Instance->CCR2) * DUTY_SCALE),
+                    .speed = Oscilloscope::to_speed(qd4310.getSpeed()),
+                    .vbus = Oscilloscope::to_voltage(qd4310.getVoltage()),
+                },
+                {
+                    .iq = qd4310.getCurrent(),
+                    .speed = qd4310.getSpeed(),
+                    .mode = static_cast<uint8_t>(qd4310.getCtrlType().type),
+                }
+            );
+        }
+        DWT_Profiler::mark(DWT_Profiler::STAGE_TOTAL, DWT_Profiler::now() - start);
+        DWT_Profiler::commit();
+        DeadlineMonitor::exit(DeadlineMonitor::CHANNEL_CURRENT_LOOP);
     }
 }
 
 __attribute__((section(".ccmram_func")))
 void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim) {
     if (&htim6 == htim) {
+        DeadlineMonitor::enter(DeadlineMonitor::CHANNEL_CTRL_LOOP, htim6.Instance->CNT * (htim6.Instance->PSC + 1));
+        qd4310.reserveCurrent(field_weakening.get_current()); // 弱磁电流从Q轴电流限幅中扣除
         qd4310.Ctrl_ISR();
+        DeadlineMonitor::exit(DeadlineMonitor::CHANNEL_CTRL_LOOP);
     }
 }
@@ -4,24 +4,32 @@
  *          start()    启动BLDC驱动
  *          stop()     关闭BLDC驱动
  *          set_duty()  设置BLDC三相占空比,归一化
+ *          set_compare() 直接设置三相比较值,供已算好比较值的调用者使用
  * @author  LiuHaoqi
- * @date    2025-4-8
- * @version V3.0.0
- * @note
- * @warning
+ * @date    2026-10-17
+ * @version V3.2.0
+ * @note    比较值直接写TIM CCR1~3,不经过HAL句柄;失能时比例为0,set_duty无分支写入0;
+ *          CCR预装载,比较值在更新事件时生效;电流环中由BLDC_Modulator算好比较值后调用set_compare()
+ * @warning 中心对齐且重复计数为0时,计数器上溢和下溢均产生更新事件,三路写入恰好跨过更新事件时,
+ *          该半个PWM周期内一路为新值、其余为旧值,与逐路写入CCR的HAL写法相同
  * @par     history:
 		    V1.0.0 on 2024-5-12
 		    V2.0.0 on 2025-1-20,refactor by C++
 		    V3.0.0 on 2025-4-8,redesign refer to SimpleFOC
 		    V3.0.1 on 2025-5-4,optimize enable() and disable() process
+		    V3.0.2 on 2026-10-17,add DWT profiling of set_duty()
+		    V3.1.0 on 2026-10-17,write CCR registers directly with preload and update-disable, add set_compare()
+		    V3.2.0 on 2026-10-17,drop the update-disable toggle, profile set_compare() used by the modulator
  * */
 
 #ifndef BLED_Driver_DRV8300_H
 #define BLED_Driver_DRV8300_H
 
+#include <algorithm>
 #include <cstdint>
 #include "tim.h"
 #include "BLDC_Driver.h"
+#include "DWT_Profiler.h"
 
 class BLDC_Driver_DRV8300 final : public BLDC_Driver {
 public:
@@ -33,6 +41,11 @@ public:
     void init() override { initialized = true; }
 
     void enable() override {
+        // 比较值预装载,在更新事件时生效(CubeMX生成的PWM配置已打开,这里确保)
+        TIM_TypeDef *const tim = htim->Instance;
+        tim->CCMR1 |= TIM_CCMR1_OC1PE | TIM_CCMR1_OC2PE;
+        tim->CCMR2 |= TIM_CCMR2_OC3PE;
+        scale = static_cast<float>(MaxDuty);
         //打开所有PWM通道输出
         HAL_TIM_PWM_Start(htim, TIM_CHANNEL_1);
         HAL_TIM_PWM_Start(htim, TIM_CHANNEL_2);
@@ -53,24 +66,36 @@ public:
         HAL_TIMEx_PWMN_Stop(htim, TIM_CHANNEL_1);
         HAL_TIMEx_PWMN_Stop(htim, TIM_CHANNEL_2);
         HAL_TIMEx_PWMN_Stop(htim, TIM_CHANNEL_3);
+        scale = 0.0f;
         enabled = false;
     }
 
-    void set_duty(float u, float v, float w) override {
-        if (enabled) {
-            u *= static_cast<float>(MaxDuty);
-            v *= static_cast<float>(MaxDuty);
-            w *= static_cast<float>(MaxDuty);
-            //设置PWM占空比
-            __HAL_TIM_SET_COMPARE(htim, TIM_CHANNEL_1, u);
-            __HAL_TIM_SET_COMPARE(htim, TIM_CHANNEL_3, v);
-            __HAL_TIM_SET_COMPARE(htim, TIM_CHANNEL_2, w);
-        }
+    void set_duty(const float u, const float v, const float w) override {
+        // 失能时scale为0,写入0;限幅编译为条件执行的浮点比较,无跳转
+        set_compare(static_cast<uint32_t>(std::clamp(u * scale, 0.0f, scale)),
+                    static_cast<uint32_t>(std::clamp(v * scale, 0.0f, scale)),
+                    static_cast<uint32_t>(std::clamp(w * scale, 0.0f, scale)));
     }
 
+    /**
+     * @brief 设置三相比较值,在下一个更新事件生效
+     * @param u U相比较值,范围[0, MaxDuty],下同
+     * @note 不检查使能状态和范围
+     */
+    void set_compare(const uint32_t u, const uint32_t v, const uint32_t w) {
+        DWT_Profiler::Scope profile(DWT_Profiler::STAGE_SET_DUTY);
+        TIM_TypeDef *const tim = htim->Instance;
+        tim->CCR1 = u;
+        tim->CCR3 = v;
+        tim->CCR2 = w;
+    }
+
+    [[nodiscard]] uint16_t get_max_duty() const { return MaxDuty; }
+
 private:
     TIM_HandleTypeDef *htim;
     uint16_t MaxDuty;
+    float scale{0.0f}; // 占空比到比较值的比例,失能时为0
 };
 
 #endif //BLED_Driver_DRV8300_H
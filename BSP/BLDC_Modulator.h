@@ -0,0 +1,261 @@
+/**
+ * @brief 		BLDC_Modulator.h库文件
+ * @detail      调制级: 包装任意BLDC_Driver,在QDrive给出的占空比写入驱动之前按母线电压归一化并注入零序分量
+ * @author 	    Haoqi Liu
+ * @date        26-10-17
+ * @version 	V1.5.0
+ * @note 		QDrive的电流环输出为归一化占空比,同样的输出在不同母线电压下对应不同的相电压,
+ *              电流环增益随母线电压变化;这里把输入占空比视为额定电压下的调制量,
+ *              即相电压 (d-0.5)·V_nominal,再按实时母线电压折算: d' = 0.5 + (d-0.5)·V_nominal/V_bus,
+ *              电流环在额定电压下整定一次即可用于整个电压范围;
+ *              SVPWM: 三相同时减去(max+min)/2再加0.5(min-max零序注入,等效于七段式SVPWM),
+ *              只要线电压不超过母线电压就不会削顶,相电压幅值最大为V_bus/√3,比SPWM的V_bus/2多约15%;
+ *              线电压超过母线电压时保持矢量方向等比例缩小;
+ *              过调制: SVPWM下允许的最大电压利用率(线电压跨度/母线电压)大于1时,超出部分先按上限等比例缩小,
+ *              再将各相限幅到[0,1],基波幅值随上限单调增大,上限趋于无穷时即为六步方波(基波2/π·V_bus),
+ *              上限1.2、2、10时基波分别为六步方波的96%、98.6%、99.9%,代价为低次谐波增加;
+ *              SPWM: 各相单独限幅到[0,1],相电压幅值超过V_bus/2后削顶失真;
+ *              电压利用率为归一化后的指令电压相对线性调制上限的比值,供弱磁控制判断电压饱和;
+ *              死区补偿: 死区使相电压平均损失 sign(i)·Td/T_pwm·V_bus,按滤波后相电流的符号给各相占空比加上
+ *              Td/T_pwm,电流在±current_band内线性过渡,避免过零附近来回切换;补偿在母线电压折算之后、零序注入之前,
+ *              本身已是实际母线下的占空比,不随母线电压折算;
+ *              比较值输出: 设置后使能期间零序注入/限幅直接在比较值单位下进行(比例并入已有的缩放系数),
+ *              结果取整后经输出函数写入,不再调用driver.set_duty()的浮点乘法与限幅;失能时仍经driver写入
+ * @warning	    未设置电压来源时不做折算;母线电压按[min_voltage, max_voltage]限幅后参与计算
+ * @par 		历史版本
+                V1.0.0创建于26-10-17
+                V1.1.0创建于26-10-17, 添加SVPWM(min-max零序注入)与SPWM调制方式,运行时可切换
+                V1.2.0创建于26-10-17, 添加SVPWM过调制(平滑过渡到六步方波)与电压利用率输出
+                V1.3.0创建于26-10-17, 添加按相电流极性的死区补偿及其校准计算
+                V1.3.1创建于26-10-17, 母线电压归一化默认关闭
+                V1.4.0创建于26-10-17, 添加比较值输出,使能期间直接输出整数比较值
+                V1.4.1创建于26-10-17, 调制方式默认SPWM
+                V1.5.0创建于26-10-17, 相电流低通系数由电流环周期和截止频率计算
+ * */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numbers>
+#include "BLDC_Driver.h"
+
+class BLDC_Modulator final : public BLDC_Driver {
+public:
+    enum class Modulation : uint8_t {
+        SPWM,  // 正弦调制,各相单独限幅
+        SVPWM, // min-max零序注入
+    };
+
+    bool vbus_compensation = false;            // 是否按母线电压归一化,默认关闭,与不经调制级时相同
+    Modulation modulation = Modulation::SPWM;  // 调制方式,默认SPWM,与不经调制级时相同
+
+    ~BLDC_Modulator() override = default;
+
+    /**
+     * @param driver 被包装的驱动
+     * @param nominal_voltage 额定电压,电流环整定时的母线电压,单位V
+     * @param min_voltage 参与折算的最小母线电压,单位V
+     * @param max_voltage 参与折算的最大母线电压,单位V
+     * @param Ts update_current()调用周期,即电流环周期,单位s
+     */
+    BLDC_Modulator(BLDC_Driver& driver, const float nominal_voltage, const float min_voltage,
+                   const float max_voltage, const float Ts) :
+        driver(driver), nominal_voltage(nominal_voltage), min_voltage(min_voltage), max_voltage(max_voltage),
+        current_filter(1.0f - expf(-2 * std::numbers::pi_v<float> * CURRENT_CUTOFF * Ts)) {
+        initialized = driver.initialized;
+    }
+
+    void init() override {
+        driver.init();
+        initialized = driver.initialized;
+    }
+
+    void enable() override {
+        driver.enable();
+        enabled = driver.enabled;
+        update_output_scale();
+    }
+
+    void disable() override {
+        driver.disable();
+        enabled = driver.enabled;
+        update_output_scale();
+    }
+
+    void set_duty(float u, float v, float w) override {
+        if (vbus_compensation && voltage_source != nullptr) {
+            const float vbus = std::clamp(voltage_source(), min_voltage, max_voltage);
+            gain = nominal_voltage / vbus;
+            u = 0.5f + (u - 0.5f) * gain;
+            v = 0.5f + (v - 0.5f) * gain;
+            w = 0.5f + (w - 0.5f) * gain;
+        }
+        duty_u = u, duty_v = v, duty_w = w;
+        if (dead_time > 0.0f) {
+            u += dead_time * std::clamp(current_u * band_scale, -1.0f, 1.0f);
+            v += dead_time * std::clamp(current_v * band_scale, -1.0f, 1.0f);
+            w += dead_time * std::clamp(current_w * band_scale, -1.0f, 1.0f);
+        }
+        if (modulation == Modulation::SVPWM)
+            inject(u, v, w);
+        else
+            clip(u, v, w);
+        if (compare_active)
+            compare_output(static_cast<uint32_t>(u), static_cast<uint32_t>(v), static_cast<uint32_t>(w));
+        else
+            driver.set_duty(u, v, w);
+    }
+
+    /**
+     * @brief 设置比较值输出,使能期间调制结果换算为比较值后由output写入,代替driver.set_duty()
+     * @param output 写入三相比较值,在电流环中每周期调用一次,nullptr为不使用
+     * @param max_compare 占空比1对应的比较值
+     */
+    void set_compare_output(void (*output)(uint32_t, uint32_t, uint32_t), const uint16_t max_compare) {
+        compare_output = output;
+        compare_scale = static_cast<float>(max_compare);
+        update_output_scale();
+    }
+
+    /**
+     * @brief 设置母线电压来源
+     * @param source 返回母线电压,单位V,在电流环中每周期调用一次
+     */
+    void set_voltage_source(float (*source)()) { voltage_source = source; }
+
+    /**
+     * @brief 更新死区补偿使用的相电流,在电流环中每周期于set_duty()之前调用
+     * @param iu,iv,iw 三相电流采样值,单位A
+     */
+    void update_current(const float iu, const float iv, const float iw) {
+        current_u += current_filter * (iu - current_u);
+        current_v += current_filter * (iv - current_v);
+        current_w += current_filter * (iw - current_w);
+    }
+
+    /**
+     * @brief 设置死区补偿
+     * @param ratio 死区时间占PWM周期的比例,0为关闭,范围[0, 0.05]
+     * @param current_band 补偿线性过渡的电流范围,单位A
+     * @return 超出范围返回false
+     */
+    bool set_dead_time(const float ratio, const float current_band) {
+        if (!(ratio >= 0.0f && ratio <= 0.05f) || !(current_band > 0.0f)) return false;
+        dead_time = ratio;
+        band_scale = 1.0f / current_band;
+        return true;
+    }
+
+    [[nodiscard]] float get_dead_time() const { return dead_time; }
+
+    /**
+     * @brief 最近一次母线电压折算后、死区补偿前的D轴电压
+     * @param theta 电角度,单位rad
+     * @return 单位为母线电压
+     */
+    [[nodiscard]] float get_voltage_d(const float theta) const {
+        constexpr float PHASE = 2 * std::numbers::pi_v<float> / 3;
+        return 2.0f / 3.0f * (duty_u * cosf(theta) + duty_v * cosf(theta - PHASE) + duty_w * cosf(theta + PHASE));
+    }
+
+    /**
+     * @brief 由两个正D轴电流下的D轴电压求死区时间,电压与电流为直线 vd = R·id + 死区项
+     * @param theta 电角度,单位rad,测量期间转子保持不动
+     * @param i1,i2 D轴电流,单位A,均大于0且不相等
+     * @param vd1,vd2 对应的D轴电压,单位为母线电压,测量时需关闭死区补偿
+     * @return 死区时间占PWM周期的比例
+     */
+    static float dead_time_from_voltages(const float theta, const float i1, const float vd1,
+                                         const float i2, const float vd2) {
+        constexpr float PHASE = 2 * std::numbers::pi_v<float> / 3;
+        // 各相电流符号为sign(cos θx),死区项的D轴分量为 Td/T·(2/3)·Σ|cos θx|
+        const float projection = 2.0f / 3.0f * (std::abs(cosf(theta)) + std::abs(cosf(theta - PHASE)) +
+                                                std::abs(cosf(theta + PHASE)));
+        return (vd1 * i2 - vd2 * i1) / (i2 - i1) / projection;
+    }
+
+    /**
+     * @brief 设置SVPWM下允许的最大电压利用率
+     * @param value 1为线性调制,大于1为过调制,范围[1, 100]
+     * @return 超出范围返回false
+     */
+    bool set_max_utilization(const float value) {
+        if (!(value >= 1.0f && value <= 100.0f)) return false;
+        max_utilization = value;
+        return true;
+    }
+
+    [[nodiscard]] float get_max_utilization() const { return max_utilization; }
+
+    [[nodiscard]] float get_utilization() const { return utilization; } // 最近一次的电压利用率,1为线性调制上限
+
+    [[nodiscard]] float get_gain() const { return gain; } // 最近一次的折算系数 V_nominal/V_bus
+
+    [[nodiscard]] uint32_t get_saturations() const { return saturations; } // 输出电压超出可用范围的次数
+
+private:
+    BLDC_Driver& driver;
+    const float nominal_voltage, min_voltage, max_voltage;
+    float (*voltage_source)() = nullptr; // 母线电压来源,单位V
+    static constexpr float CURRENT_CUTOFF = 2200.0f; // 死区补偿判断电流极性的相电流低通截止频率,单位Hz
+    const float current_filter;                      // 相电流一阶低通系数,20kHz下约0.5
+    void (*compare_output)(uint32_t, uint32_t, uint32_t) = nullptr; // 比较值输出
+    float compare_scale{1.0f};                                       // 占空比1对应的比较值
+    bool compare_active{false};                                      // 使能且设置了比较值输出
+    float output_scale{1.0f}, output_mid{0.5f};                       // 输出单位下的满量程和中点
+
+    float gain{1.0f};
+    float dead_time{0.0f};                                  // 死区时间占PWM周期的比例
+    float band_scale{1.0f};                                 // 补偿线性过渡电流范围的倒数
+    float current_u{0.0f}, current_v{0.0f}, current_w{0.0f}; // 滤波后的相电流,单位A
+    float duty_u{0.5f}, duty_v{0.5f}, duty_w{0.5f};         // 母线电压折算后、死区补偿前的占空比
+    float max_utilization{1.0f};
+    float utilization{0.0f};
+    uint32_t saturations{0};
+
+    /**
+     * @brief 使能且设置了比较值输出时以比较值为输出单位,否则为占空比
+     */
+    void update_output_scale() {
+        compare_active = enabled && compare_output != nullptr;
+        output_scale = compare_active ? compare_scale : 1.0f;
+        output_mid = 0.5f * output_scale;
+    }
+
+    /**
+     * @brief min-max零序注入: 三相中点移到0.5,跨度超过max_utilization时以0.5为中心等比例缩小,
+     *        仍超过1(过调制)时各相限幅到[0,1];结果按output_scale换算为输出单位
+     */
+    void inject(float& u, float& v, float& w) {
+        const float max = std::max({u, v, w}), min = std::min({u, v, w});
+        const float mid = (max + min) * 0.5f, span = max - min;
+        utilization = span;
+        float k = output_scale;
+        if (span > max_utilization) {
+            k = max_utilization / span * output_scale;
+            ++saturations;
+        }
+        u = output_mid + (u - mid) * k;
+        v = output_mid + (v - mid) * k;
+        w = output_mid + (w - mid) * k;
+        if (span > 1.0f && max_utilization > 1.0f) {
+            u = std::clamp(u, 0.0f, output_scale);
+            v = std::clamp(v, 0.0f, output_scale);
+            w = std::clamp(w, 0.0f, output_scale);
+        }
+    }
+
+    /**
+     * @brief 各相单独限幅到[0,1],结果按output_scale换算为输出单位
+     */
+    void clip(float& u, float& v, float& w) {
+        const float max = std::max({u, v, w}), min = std::min({u, v, w});
+        utilization = 2 * std::max(max - 0.5f, 0.5f - min);
+        if (utilization > 1.0f) ++saturations;
+        u = std::clamp(u, 0.0f, 1.0f) * output_scale;
+        v = std::clamp(v, 0.0f, 1.0f) * output_scale;
+        w = std::clamp(w, 0.0f, 1.0f) * output_scale;
+    }
+};
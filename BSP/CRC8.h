@@ -0,0 +1,95 @@
+/**
+ * @brief 		CRC8.h库文件
+ * @detail      CRC8校验: 逐位计算的通用实现,以及编译期生成256项查找表的特化实现
+ * @author 	    Haoqi Liu
+ * @date        26-10-17
+ * @version 	V1.0.0
+ * @note 		通用实现CRC8()由CommunicateTask.cpp迁移而来,接口不变,可用于任意多项式;
+ *              CRC-8参数模型中refin与refout不同的组合只能使用通用实现;
+ *              固定参数的高频调用(如通信协议)应使用CRC8_Table,每字节只需一次查表
+ * @warning
+ * @par 		历史版本
+                V1.0.0创建于26-10-17
+ * */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+/**
+ * @brief 反转字节(按bit反转)
+ */
+constexpr uint8_t ReverseBits(uint8_t data) {
+    data = (data & 0x55) << 1 | (data & 0xAA) >> 1;
+    data = (data & 0x33) << 2 | (data & 0xCC) >> 2;
+    data = (data & 0x0F) << 4 | (data & 0xF0) >> 4;
+    return data;
+}
+
+/**
+ * @brief 通用CRC8,逐位计算
+ * @param data 数据
+ * @param len 数据长度,必须大于0
+ * @param polynomial 多项式
+ * @param init 初始值
+ * @param xor_out 结果异或值
+ * @param input_invert 输入是否按位反转
+ * @param output_invert 输出是否按位反转
+ */
+inline uint8_t CRC8(const uint8_t *data, uint32_t len, uint8_t polynomial, uint8_t init,
+                    uint8_t xor_out, bool input_invert, bool output_invert) {
+    uint8_t crc = init;
+    do {
+        crc ^= input_invert ? ReverseBits(*(data++)) : *(data++);
+        for (uint8_t i = 0; i < 8; ++i) {
+            if (crc & 0x80) {
+                crc = (crc << 1) ^ polynomial;
+            } else {
+                crc <<= 1;
+            }
+        }
+    } while (--len);
+    return output_invert ? ReverseBits(crc ^ xor_out) : (crc ^ xor_out);
+}
+
+/**
+ * @brief 查表法CRC8,查找表在编译期生成
+ * @tparam Polynomial 多项式
+ * @tparam Init 初始值
+ * @tparam XorOut 结果异或值
+ * @tparam Reflect 输入输出是否按位反转(即CRC参数模型中的refin=refout)
+ */
+template <uint8_t Polynomial, uint8_t Init, uint8_t XorOut, bool Reflect>
+class CRC8_Table {
+public:
+    static constexpr std::array<uint8_t, 256> table = [] {
+        std::array<uint8_t, 256> t{};
+        for (uint16_t i = 0; i < 256; ++i) {
+            uint8_t crc = static_cast<uint8_t>(i);
+            for (uint8_t bit = 0; bit < 8; ++bit) {
+                if constexpr (Reflect)
+                    crc = crc & 0x01 ? crc >> 1 ^ ReverseBits(Polynomial) : crc >> 1;
+                else
+                    crc = crc & 0x80 ? static_cast<uint8_t>(crc << 1 ^ Polynomial) : static_cast<uint8_t>(crc << 1);
+            }
+            t[i] = crc;
+        }
+        return t;
+    }();
+
+    /**
+     * @brief 计算CRC8
+     * @param data 数据
+     * @param len 数据长度
+     */
+    static constexpr uint8_t compute(const uint8_t *data, uint32_t len) {
+        // 反转算法中寄存器保存的是反转后的值,初始值也需反转
+        uint8_t crc = Reflect ? ReverseBits(Init) : Init;
+        while (len--) crc = table[crc ^ *data++];
+        return crc ^ XorOut;
+    }
+};
+
+// 通信协议使用的CRC-8: 多项式0x07,初始值0x00,结果异或值0x00,不反转输入输出
+using CRC8_Protocol = CRC8_Table<0x07, 0x00, 0x00, false>;
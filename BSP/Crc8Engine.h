@@ -0,0 +1,108 @@
+/**
+ * @brief 		Crc8Engine.h库文件
+ * @detail      通信协议CRC-8(多项式0x07,初始值0x00,结果异或值0x00,不反转)的计算引擎,
+ *              提供STM32G4硬件CRC单元后端和查表法软件后端,接口一致
+ * @author 	    Haoqi Liu
+ * @date        26-10-17
+ * @version 	V1.1.0
+ * @note 		Crc8Engine在固件中为硬件后端,在没有CRC外设的环境(主机仿真)中为软件后端;
+ *              硬件后端每字节只需一次寄存器写入,不占用查找表的Flash读取带宽
+ * @warning	    硬件后端在UART接收中断和通信任务中共用,compute()在临界区内完成,
+ *              使用前需调用init(),且不可再被其他模块以不同配置使用;
+ *              init()以软件后端自检硬件配置,结果不一致时compute()退回软件后端
+ * @par 		历史版本
+                V1.0.0创建于26-10-17
+                V1.1.0创建于26-10-17, 硬件后端添加与软件后端对比的自检,自检失败时退回软件后端
+ * */
+
+#pragma once
+
+#include <cstdint>
+#include "main.h"
+#include "CRC8.h"
+
+/**
+ * @brief 软件后端,使用编译期生成的查找表
+ */
+class Crc8Engine_Software {
+public:
+    static bool init() { return true; }
+
+    static uint8_t compute(const uint8_t *data, const uint32_t len) {
+        return CRC8_Protocol::compute(data, len);
+    }
+};
+
+#ifdef CRC
+
+/**
+ * @brief 硬件后端,使用CRC外设,寄存器级操作,无需开启HAL_CRC_MODULE
+ */
+class Crc8Engine_Hardware {
+public:
+    /**
+     * @brief 配置CRC外设并自检
+     * @return 自检通过返回true,否则compute()使用软件后端
+     */
+    static bool init() {
+        __HAL_RCC_CRC_CLK_ENABLE();
+        CRC->POL = 0x07;
+        CRC->INIT = 0x00;
+        CRC->CR = CRC_CR_POLYSIZE_1; // 8位多项式,不反转输入输出
+        fallback = false;
+        mismatches = self_test();
+        fallback = mismatches != 0;
+        return !fallback;
+    }
+
+    /**
+     * @brief 以软件后端为参考,对比全部单字节输入和协议帧长(4、9字节)的伪随机帧
+     * @return 结果不一致的次数
+     */
+    static uint32_t self_test() {
+        uint32_t errors = 0;
+        for (uint16_t i = 0; i < 256; ++i) {
+            const auto byte = static_cast<uint8_t>(i);
+            errors += compute_hardware(&byte, 1) != Crc8Engine_Software::compute(&byte, 1);
+        }
+        uint8_t frame[9];
+        uint32_t seed = 0x12345678;
+        for (uint32_t i = 0; i < 256; ++i) {
+            for (auto& byte : frame) {
+                seed = seed * 1664525u + 1013904223u;
+                byte = static_cast<uint8_t>(seed >> 24);
+            }
+            errors += compute_hardware(frame, 4) != Crc8Engine_Software::compute(frame, 4);
+            errors += compute_hardware(frame, 9) != Crc8Engine_Software::compute(frame, 9);
+        }
+        return errors;
+    }
+
+    static uint8_t compute(const uint8_t *data, const uint32_t len) {
+        if (fallback) return Crc8Engine_Software::compute(data, len);
+        return compute_hardware(data, len);
+    }
+
+    static uint8_t compute_hardware(const uint8_t *data, uint32_t len) {
+        const uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        CRC->CR |= CRC_CR_RESET;
+        while (len--) *reinterpret_cast<__IO uint8_t *>(&CRC->DR) = *data++;
+        const auto crc = static_cast<uint8_t>(CRC->DR);
+        __set_PRIMASK(primask);
+        return crc;
+    }
+
+    [[nodiscard]] static bool is_fallback() { return fallback; }
+
+    [[nodiscard]] static uint32_t get_mismatches() { return mismatches; } // init()自检的不一致次数
+
+private:
+    inline static bool fallback{false};     // 自检失败,使用软件后端
+    inline static uint32_t mismatches{0};
+};
+
+using Crc8Engine = Crc8Engine_Hardware;
+#else
+using Crc8Engine = Crc8Engine_Software;
+#endif
@@ -0,0 +1,105 @@
+/**
+ * @brief 		CurrentOffsetTracker.h库文件
+ * @detail      电流采样零点跟踪: PWM关闭且转子静止时,相电流应为0,以测得的残差缓慢修正电流偏置,
+ *              补偿运放和ADC零点随温度的漂移
+ * @author 	    Haoqi Liu
+ * @date        26-10-17
+ * @version 	V1.0.0
+ * @note 		每次update()将偏置减去 残差·Ts/τ,残差由已含当前偏置的相电流读数给出,
+ *              等效于对原始零点做时间常数为τ的一阶低通,不依赖偏置的初值和符号约定;
+ *              只修正实际采样的相(两电阻为U、V,三电阻按当前采样相),重构相不修正;
+ *              空闲后先等待settle_time再开始跟踪,单相残差超过max_residual的样本视为有真实电流而丢弃
+ * @warning	    idle需由调用方保证: PWM关闭、未在校准、转子静止(否则反电动势经体二极管产生电流);
+ *              修正只作用于电流传感器,不写入Flash,重新上电后由校准值重新收敛
+ * @par 		历史版本
+                V1.0.0创建于26-10-17
+ * */
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include "CurrentSensor_Embed.h"
+
+class CurrentOffsetTracker {
+public:
+    /**
+     * @param sensor 电流传感器
+     * @param Ts update()调用周期,单位s
+     * @param time_constant 跟踪时间常数,单位s
+     * @param settle_time 空闲后开始跟踪前的等待时间,单位s
+     * @param max_residual 有效样本的最大单相残差,单位A
+     */
+    CurrentOffsetTracker(CurrentSensor_Embed& sensor, const float Ts, const float time_constant,
+                         const float settle_time = 0.2f, const float max_residual = 0.05f) :
+        sensor(sensor), Ts(Ts), settle_time(settle_time), max_residual(max_residual) {
+        set_time_constant(time_constant);
+    }
+
+    /**
+     * @brief 跟踪一次,以Ts周期在后台任务中调用
+     * @param idle 当前满足跟踪条件
+     */
+    void update(const bool idle) {
+        if (!idle) {
+            idle_time = 0;
+            tracking = false;
+            return;
+        }
+        if (idle_time < settle_time) {
+            idle_time += Ts;
+            return;
+        }
+        tracking = true;
+
+        using Phases = CurrentSensor_Embed::Phases;
+        const Phases phases = sensor.get_phases();
+        const bool track_u = phases != Phases::VW;
+        const bool track_v = phases != Phases::UW;
+        const bool track_w = sensor.is_three_shunt() && phases != Phases::UV;
+        const float ru = track_u ? sensor.iu : 0.0f;
+        const float rv = track_v ? sensor.iv : 0.0f;
+        const float rw = track_w ? sensor.iw : 0.0f;
+        if (std::abs(ru) > max_residual || std::abs(rv) > max_residual || std::abs(rw) > max_residual) {
+            ++rejected;
+            return;
+        }
+
+        float iu_offset, iv_offset, iw_offset;
+        sensor.get_offset(iu_offset, iv_offset, iw_offset);
+        sensor.set_offset(iu_offset - gain * ru, iv_offset - gain * rv, iw_offset - gain * rw);
+        ++samples;
+    }
+
+    /**
+     * @brief 设置跟踪时间常数
+     * @param seconds 时间常数,单位s,需大于Ts
+     * @return 超出范围返回false
+     */
+    bool set_time_constant(const float seconds) {
+        if (!(seconds > Ts)) return false;
+        time_constant = seconds;
+        gain = Ts / seconds;
+        return true;
+    }
+
+    [[nodiscard]] float get_time_constant() const { return time_constant; }
+
+    [[nodiscard]] bool is_tracking() const { return tracking; }
+
+    [[nodiscard]] uint32_t get_samples() const { return samples; }   // 已用于修正的样本数
+
+    [[nodiscard]] uint32_t get_rejected() const { return rejected; } // 残差过大被丢弃的样本数
+
+private:
+    CurrentSensor_Embed& sensor;
+    const float Ts;
+    const float settle_time;
+    const float max_residual;
+    float time_constant{};
+    float gain{};         // 每次修正的比例,Ts/τ
+    float idle_time{0.0f}; // 连续空闲时间,单位s
+    bool tracking{false};
+    uint32_t samples{0};
+    uint32_t rejected{0};
+};
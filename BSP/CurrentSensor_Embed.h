@@ -1,15 +1,64 @@
-//
-// Created by 26757 on 25-5-4.
-//
+/**
+ * @brief 		CurrentSensor_Embed.h库文件
+ * @detail      使用片上ADC1/ADC2双ADC注入同步采样的相电流传感器
+ * @author 	    Haoqi Liu
+ * @date        26-10-17
+ * @version 	V1.6.0
+ * @note 		可开启注入组硬件过采样(2~16倍): 一次触发连续转换N次,JDR为N次结果之和(不右移),
+ *              update()中按N折算,保留平均带来的额外分辨率,CPU开销与单次采样相同;
+ *              绑定触发定时器后,触发点提前半个采样窗口,使窗口中心仍位于原触发时刻;
+ *              update()中增益(含过采样折算)与偏置(含零点和电流偏置)已预先合并,每相只需一次乘加;
+ *              update_q15()输出Q15定点电流,满量程为ADC半量程对应的电流,供FixedPointFOC使用;
+ *              三电阻采样(enable_three_shunt)时,每周期写入新占空比后调用select_phases(),
+ *              下一次采样避开占空比最大(下桥导通最短)的一相,由另两相重构,提高可用调制深度;
+ *              set_double_rate()开启后在PWM波峰附近再触发一次注入转换,电流环频率为PWM频率的2倍
+ * @warning	    过采样窗口需落在下桥导通区间内,16倍时窗口约5.3us,占空比上限相应降低;
+ *              三电阻采样要求W相接在ADC1、ADC2共用的引脚(ADC12_INx)上,且引脚已配置为模拟输入;
+ *              核心校准在零矢量下进行(只采样U、V),W相只有标称零点和iw_offset修正;
+ *              波峰处为另一种零矢量,下桥采样电阻中没有相电流,倍频需要相线串联采样电阻或霍尔电流传感器
+ * @par 		历史版本
+                V1.0.0创建于25-5-4
+                V1.1.0创建于26-10-17, 添加注入组硬件过采样
+                V1.2.0创建于26-10-17, 增益与偏置预先合并,每相一次乘加;添加Q15定点输出
+                V1.3.0创建于26-10-17, 添加三电阻采样,按占空比选择下桥导通最长的两相
+                V1.4.0创建于26-10-17, set_offset()关中断整体更新,可在电流环运行时调用;添加get_offset()
+                V1.5.0创建于26-10-17, 修改过采样配置时兼容由外部触发的规则组(母线电压DMA采样)
+                V1.6.0创建于26-10-17, 添加波峰波谷双触发(电流环倍频)
+ * */
+
 #pragma once
 
 #include "CurrentSensor.h"
+#include "FixedPointFOC.h"
 #include "adc.h"
+#include "tim.h"
 
 class CurrentSensor_Embed final : public CurrentSensor {
 public:
-    CurrentSensor_Embed(ADC_HandleTypeDef *hadc1, ADC_HandleTypeDef *hadc2) :
-        hadc1(hadc1), hadc2(hadc2) {}
+    // 三电阻采样时实际采样的两相,第三相由两相之和重构
+    enum class Phases : uint8_t {
+        UV, // ADC1采样V相,ADC2采样U相
+        VW, // ADC1采样V相,ADC2采样W相
+        UW, // ADC1采样W相,ADC2采样U相
+    };
+
+    static constexpr uint8_t MAX_OVERSAMPLING = 16; // JDR为16位,16次12位结果之和不会溢出
+    static constexpr float V_REF = 3.3f;              // ADC基准电压,单位:V
+    static constexpr float ADC_REVOLUTION = 4096 - 1; // ADC分辨率
+    static constexpr float OP_AMP_GAIN = 20.0f;       // 差分运放电压增益,单位:V/V
+    static constexpr float R_SENSE = 0.05f;           // 采样电阻阻值,单位:Ω
+    static constexpr float LSB = V_REF / ADC_REVOLUTION / OP_AMP_GAIN / R_SENSE; // 单次转换每LSB的电流,单位:A
+    static constexpr float FULL_SCALE = 2048 * LSB;   // Q15电流的满量程,单位:A
+
+    /**
+     * @param hadc1 ADC1句柄,双ADC模式的主ADC
+     * @param hadc2 ADC2句柄
+     * @param oversampling 过采样倍数,1/2/4/8/16,无效时为1
+     */
+    CurrentSensor_Embed(ADC_HandleTypeDef *hadc1, ADC_HandleTypeDef *hadc2, const uint8_t oversampling = 1) :
+        hadc1(hadc1), hadc2(hadc2) {
+        set_ratio(is_valid(oversampling) ? oversampling : 1);
+    }
 
     void init() override {
         HAL_ADCEx_Calibration_Start(hadc1, ADC_SINGLE_ENDED); //校准ADC
@@ -20,6 +69,8 @@ public:
     void enable() override {
         ADC_Enable(hadc1);
         ADC_Enable(hadc2);
+        apply_oversampling();
+        if (three_shunt) apply_three_shunt();
         HAL_ADCEx_InjectedStart_IT(hadc1); //开启ADC采样
         enabled = true;
     }
@@ -31,28 +82,288 @@ public:
         enabled = false;
     }
 
+    /**
+     * @note 偏置与合并后的增益偏置在关中断下一起更新,电流环中断不会读到新旧混合的值
+     */
     void set_offset(const float iu_offset, const float iv_offset, const float iw_offset) override {
+        const uint32_t primask = __get_PRIMASK();
+        __disable_irq();
         this->iu_offset = iu_offset;
         this->iv_offset = iv_offset;
         this->iw_offset = iw_offset;
+        fold();
+        __set_PRIMASK(primask);
+    }
+
+    void get_offset(float& iu_offset, float& iv_offset, float& iw_offset) const {
+        iu_offset = this->iu_offset;
+        iv_offset = this->iv_offset;
+        iw_offset = this->iw_offset;
+    }
+
+    /**
+     * @brief 绑定注入触发所在的定时器通道,之后按过采样窗口调整其比较值
+     * @param htim 触发定时器,需为中心对齐模式,向下计数经过比较值时触发
+     * @param channel 触发通道,如TIM_CHANNEL_4
+     */
+    void attach_trigger(TIM_HandleTypeDef *htim, const uint32_t channel) {
+        this->htim = htim;
+        this->channel = channel;
+        trigger_pulse = __HAL_TIM_GET_COMPARE(htim, channel);
+        apply_trigger();
+    }
+
+    /**
+     * @brief 切换注入触发: 单倍频只在PWM波谷附近触发,倍频时在波峰附近再触发一次
+     * @param enable true为倍频
+     * @return 未绑定触发通道或触发通道不是CH4时返回false
+     * @note 波峰触发由OC6(PWM2模式,向上计数经过CCR6时上升)产生,CCR6与CCR4关于ARR对称,
+     *       TRGO2在OC4REF与"OC4REF或OC6REF上升沿"之间切换;
+     *       倍频要求重复计数器为0,使CCR预装载在波峰和波谷的更新事件都载入;
+     *       中心对齐模式1下CC4的DMA请求只在向下计数时产生,波峰触发不启动编码器读取
+     */
+    bool set_double_rate(const bool enable) {
+        if (htim == nullptr || channel != TIM_CHANNEL_4) return false;
+        TIM_TypeDef *tim = htim->Instance;
+        double_rate = enable;
+        if (enable) {
+            tim->RCR = 0;
+            MODIFY_REG(tim->CCMR3, TIM_CCMR3_OC6M | TIM_CCMR3_OC6PE, TIM_OCMODE_PWM2 << 8U);
+        }
+        apply_trigger();
+        MODIFY_REG(tim->CR2, TIM_CR2_MMS2, enable ? TIM_TRGO2_OC4REF_RISING_OC6REF_RISING : TIM_TRGO2_OC4REF);
+        return true;
+    }
+
+    [[nodiscard]] bool is_double_rate() const { return double_rate; }
+
+    /**
+     * @brief 设置过采样倍数,采样运行中时短暂停止注入转换后重新开启
+     * @param ratio 过采样倍数,1/2/4/8/16
+     * @return 倍数无效时返回false
+     */
+    bool set_oversampling(const uint8_t ratio) {
+        if (!is_valid(ratio)) return false;
+        const bool running = enabled;
+        if (running) HAL_ADCEx_InjectedStop_IT(hadc1);
+        set_ratio(ratio);
+        if (running) {
+            apply_oversampling();
+            HAL_ADCEx_InjectedStart_IT(hadc1);
+        }
+        apply_trigger();
+        return true;
+    }
+
+    [[nodiscard]] uint8_t get_oversampling() const { return oversampling; }
+
+    /**
+     * @brief 开启三电阻采样,需在ADC初始化之后、enable()之前调用
+     * @param w_channel W相的ADC通道号(ADC12_INx的x)
+     * @param w_inverted W相运放极性与U相相同(读数随电流增大而减小)时为true,与V相相同时为false
+     */
+    void enable_three_shunt(const uint8_t w_channel, const bool w_inverted) {
+        this->w_channel = w_channel;
+        this->w_inverted = w_inverted;
+        u_channel = (hadc2->Instance->JSQR & ADC_JSQR_JSQ1) >> ADC_JSQR_JSQ1_Pos;
+        v_channel = (hadc1->Instance->JSQR & ADC_JSQR_JSQ1) >> ADC_JSQR_JSQ1_Pos;
+        jsqr1 = hadc1->Instance->JSQR & ~ADC_JSQR_JSQ1;
+        jsqr2 = hadc2->Instance->JSQR & ~ADC_JSQR_JSQ1;
+        three_shunt = true;
+        fold();
+    }
+
+    [[nodiscard]] bool is_three_shunt() const { return three_shunt; }
+
+    [[nodiscard]] Phases get_phases() const { return phases; }
+
+    /**
+     * @brief 按新写入的占空比选择下一次采样的两相,跳过占空比最大的一相
+     * @param ccr_u U相比较值
+     * @param ccr_v V相比较值
+     * @param ccr_w W相比较值
+     * @note 在电流环中断中写入占空比之后调用,新序列由ADC注入队列在下一次触发时载入;
+     *       中断超时跨过下一次触发时,该次采样的通道与phases不一致
+     */
+    void select_phases(const uint32_t ccr_u, const uint32_t ccr_v, const uint32_t ccr_w) {
+        if (!three_shunt) return;
+        Phases next = Phases::UV;
+        if (ccr_u >= ccr_v && ccr_u >= ccr_w) next = Phases::VW;
+        else if (ccr_v >= ccr_w) next = Phases::UW;
+        if (next == phases) return;
+        phases = next;
+        write_sequence();
     }
 
     void update() {
-        static constexpr float V_REF = 3.3f;              // ADC基准电压,单位:V
-        static constexpr float ADC_REVOLUTION = 4096 - 1; // ADC分辨率
-        static constexpr float OP_AMP_GAIN = 20.0f;       // 差分运放电压增益,单位:V/V
-        static constexpr float R_SENSE = 0.05f;           // 采样电阻阻值,单位:Ω
+        const auto adc1 = static_cast<float>(hadc1->Instance->JDR1);
+        const auto adc2 = static_cast<float>(hadc2->Instance->JDR1);
+        switch (phases) {
+            case Phases::UV:
+                this->iu = adc2 * gain_u + bias_u;
+                this->iv = adc1 * gain_v + bias_v;
+                this->iw = bias_w_uv - (this->iu + this->iv);
+                break;
+            case Phases::VW:
+                this->iv = adc1 * gain_v + bias_v;
+                this->iw = adc2 * gain_w + bias_w;
+                this->iu = -(this->iv + this->iw);
+                break;
+            case Phases::UW:
+                this->iu = adc2 * gain_u + bias_u;
+                this->iw = adc1 * gain_w + bias_w;
+                this->iv = -(this->iu + this->iw);
+                break;
+        }
+    }
 
-        const float iu = 2048 - static_cast<float>(hadc2->Instance->JDR1);
-        this->iu = iu_offset + iu / ADC_REVOLUTION * V_REF / OP_AMP_GAIN / R_SENSE;
-        const float iv = static_cast<float>(hadc1->Instance->JDR1) - 2048;
-        this->iv = iv_offset + iv / ADC_REVOLUTION * V_REF / OP_AMP_GAIN / R_SENSE;
-        this->iw = iw_offset - (this->iu + this->iv);
+    /**
+     * @brief 以定点读取相电流,不更新浮点的iu/iv/iw
+     * @param iu U相电流,Q15,满量程FULL_SCALE
+     * @param iv V相电流,Q15,满量程FULL_SCALE
+     */
+    void update_q15(FixedPointFOC::q15& iu, FixedPointFOC::q15& iv) const {
+        const int32_t adc1 = static_cast<int32_t>(hadc1->Instance->JDR1) - adc_mid_q;
+        const int32_t adc2 = static_cast<int32_t>(hadc2->Instance->JDR1) - adc_mid_q;
+        const auto phase_w = [this](const int32_t adc) {
+            return ((w_inverted ? -adc : adc) << shift_q) + offset_w_q;
+        };
+        int32_t u, v;
+        switch (phases) {
+            case Phases::UV:
+                u = (-adc2 << shift_q) + offset_u_q;
+                v = (adc1 << shift_q) + offset_v_q;
+                break;
+            case Phases::VW:
+                v = (adc1 << shift_q) + offset_v_q;
+                u = -(v + phase_w(adc2));
+                break;
+            case Phases::UW:
+            default:
+                u = (-adc2 << shift_q) + offset_u_q;
+                v = -(u + phase_w(adc1));
+                break;
+        }
+        iu = FixedPointFOC::saturate(u);
+        iv = FixedPointFOC::saturate(v);
     }
 
 private:
+    static constexpr uint32_t CONVERSION_CYCLES = 15; // 单次转换的ADC时钟数,2.5采样+12.5转换,与adc.c一致
+    static constexpr uint32_t ADC_CLOCK_DIVIDER = 4;  // ADC时钟为HCLK的1/4(ADC_CLOCK_SYNC_PCLK_DIV4)
+
     float iu_offset{}, iv_offset{}, iw_offset{}; // 电流偏置,单位A
 
     ADC_HandleTypeDef *hadc1;
     ADC_HandleTypeDef *hadc2;
+    TIM_HandleTypeDef *htim{nullptr}; // 注入触发定时器
+    uint32_t channel{};               // 注入触发通道
+    uint32_t trigger_pulse{};         // 单次采样时的触发比较值
+    bool double_rate{false};          // 波峰波谷双触发
+
+    uint8_t oversampling{1}; // 过采样倍数
+    float gain_u{}, gain_v{}; // JDR每个计数对应的电流,含过采样折算和极性,单位A
+    float bias_u{}, bias_v{}; // JDR为0时对应的电流,含零点和电流偏置,单位A
+    int32_t adc_mid_q{};      // 零电流对应的JDR值
+    uint8_t shift_q{};        // JDR计数转为Q15的左移位数
+    int32_t offset_u_q{}, offset_v_q{}; // 电流偏置,Q15
+
+    bool three_shunt{false};     // 三电阻采样
+    bool w_inverted{false};      // W相运放极性与U相相同
+    uint8_t w_channel{};         // W相的ADC通道号
+    uint8_t u_channel{};         // U相的ADC2通道号,由CubeMX配置的注入序列读出
+    uint8_t v_channel{};         // V相的ADC1通道号,由CubeMX配置的注入序列读出
+    uint32_t jsqr1{}, jsqr2{};   // 去掉JSQ1后的注入序列(触发源、长度)
+    Phases phases{Phases::UV};   // 当前(下一次读取的)采样相
+    float gain_w{}, bias_w{};    // W相增益与偏置,单位A
+    float bias_w_uv{};           // 采样U、V时W相的重构偏置,两电阻时为iw_offset,三电阻时W相偏置已用于采样,为0
+    int32_t offset_w_q{};        // W相电流偏置,Q15
+
+    static bool is_valid(const uint8_t ratio) {
+        return ratio != 0 && ratio <= MAX_OVERSAMPLING && (ratio & (ratio - 1)) == 0;
+    }
+
+    void set_ratio(const uint8_t ratio) {
+        oversampling = ratio;
+        fold();
+    }
+
+    /**
+     * @brief 合并增益与偏置: U相 i=(mid-JDR)·k+offset,V相 i=(JDR-mid)·k+offset,k=LSB/N
+     */
+    void fold() {
+        const float mid = 2048.0f * static_cast<float>(oversampling);
+        const float k = LSB / static_cast<float>(oversampling);
+        gain_u = -k;
+        bias_u = iu_offset + mid * k;
+        gain_v = k;
+        bias_v = iv_offset - mid * k;
+        uint8_t log2 = 0;
+        while ((1u << log2) < oversampling) ++log2;
+        adc_mid_q = 2048 * oversampling;
+        shift_q = 4 - log2; // 2048·N个计数对应Q15的32768
+        offset_u_q = FixedPointFOC::from_float(iu_offset, FULL_SCALE);
+        offset_v_q = FixedPointFOC::from_float(iv_offset, FULL_SCALE);
+        gain_w = w_inverted ? -k : k;
+        bias_w = iw_offset - mid * gain_w;
+        bias_w_uv = three_shunt ? 0.0f : iw_offset;
+        offset_w_q = FixedPointFOC::from_float(iw_offset, FULL_SCALE);
+    }
+
+    /**
+     * @brief 开启注入队列并配置W相通道,需在注入转换停止时调用
+     * @note JQDIS清零、JQM为0时,JSQR写入进入队列,每次触发载入一个,队列空时保持最后一个,
+     *       因此只需在采样相改变时写入
+     */
+    void apply_three_shunt() {
+        for (ADC_TypeDef *adc: {hadc1->Instance, hadc2->Instance}) {
+            LL_ADC_SetChannelSamplingTime(adc, __LL_ADC_DECIMAL_NB_TO_CHANNEL(w_channel), LL_ADC_SAMPLINGTIME_2CYCLES_5);
+            CLEAR_BIT(adc->CFGR, ADC_CFGR_JQDIS | ADC_CFGR_JQM);
+        }
+        phases = Phases::UV;
+        write_sequence();
+    }
+
+    /**
+     * @brief 按phases写入两个ADC的注入序列
+     */
+    void write_sequence() const {
+        const uint32_t ch1 = phases == Phases::UW ? w_channel : v_channel;
+        const uint32_t ch2 = phases == Phases::VW ? w_channel : u_channel;
+        hadc1->Instance->JSQR = jsqr1 | ch1 << ADC_JSQR_JSQ1_Pos;
+        hadc2->Instance->JSQR = jsqr2 | ch2 << ADC_JSQR_JSQ1_Pos;
+    }
+
+    /**
+     * @brief 写入两个ADC的过采样配置,需在注入转换停止时调用
+     * @note OVSR/OVSS与规则组共用,规则组(母线电压)不开启过采样,不受影响;
+     *       修改时规则转换也不能进行,关中断等待其结束,避免期间被其他任务再次启动;
+     *       规则组由外部触发时ADSTART一直置位,先停止,修改后重新开始等待触发
+     */
+    void apply_oversampling() const {
+        uint32_t log2 = 0;
+        while ((1u << log2) < oversampling) ++log2;
+        // OVSR为log2(N)-1,OVSS为0即不右移
+        const uint32_t cfgr2 = oversampling > 1 ? ADC_CFGR2_JOVSE | (log2 - 1) << ADC_CFGR2_OVSR_Pos : 0;
+        const uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        const bool regular_triggered = (hadc1->Instance->CR & ADC_CR_ADSTART) && (hadc1->Instance->CFGR & ADC_CFGR_EXTEN);
+        if (regular_triggered) LL_ADC_REG_StopConversion(hadc1->Instance);
+        while ((hadc1->Instance->CR | hadc2->Instance->CR) & ADC_CR_ADSTART) {}
+        MODIFY_REG(hadc1->Instance->CFGR2, ADC_CFGR2_JOVSE | ADC_CFGR2_OVSR | ADC_CFGR2_OVSS, cfgr2);
+        MODIFY_REG(hadc2->Instance->CFGR2, ADC_CFGR2_JOVSE | ADC_CFGR2_OVSR | ADC_CFGR2_OVSS, cfgr2);
+        if (regular_triggered) LL_ADC_REG_StartConversion(hadc1->Instance);
+        __set_PRIMASK(primask);
+    }
+
+    /**
+     * @brief 触发点提前(N-1)/2次转换的时间,使采样窗口中心位于原触发时刻;倍频时波峰触发点与之对称
+     */
+    void apply_trigger() const {
+        if (htim == nullptr) return;
+        const uint32_t ticks = CONVERSION_CYCLES * ADC_CLOCK_DIVIDER / (htim->Instance->PSC + 1); // 每次转换的计数值
+        const uint32_t pulse = trigger_pulse + ticks * (oversampling - 1) / 2;
+        __HAL_TIM_SET_COMPARE(htim, channel, pulse);
+        if (double_rate) __HAL_TIM_SET_COMPARE(htim, TIM_CHANNEL_6, htim->Instance->ARR - pulse);
+    }
 };
@@ -0,0 +1,158 @@
+/**
+ * @brief 		DWT_Profiler.h库文件
+ * @detail      使用DWT周期计数器统计电流环中断各阶段耗时(最小/最大/平均值及粗粒度直方图)
+ * @author 	    Haoqi Liu
+ * @date        26-10-17
+ * @version 	V1.1.1
+ * @note 		电流环中断开头调用begin(),各阶段耗时由mark()暂存,中断结束时由commit()统一计入统计;
+ *              begin()与commit()之外的mark()被丢弃,因此在中断外调用的阶段(如disable()中的set_duty)不会混入统计,
+ *              也不会在任务中修改marked而与中断竞争
+ * @warning	    统计数据在中断中更新,读取请使用snapshot()
+ * @par 		历史版本
+                V1.0.0创建于26-10-17
+                V1.1.0创建于26-10-17, 添加begin(),丢弃电流环中断之外的mark()
+                V1.1.1创建于26-10-17, 占空比写入阶段改由set_compare()计时
+ * */
+
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+#include "main.h"
+
+class DWT_Profiler {
+public:
+    enum Stage : uint8_t {
+        STAGE_CURRENT_SENSE = 0, // 电流采样 CurrentSensor_Embed::update()
+        STAGE_ENCODER_READ,      // 编码器读取 Encoder::get_angle()
+        STAGE_TRANSFORM_PID,     // 坐标变换与Q/D轴PID, 即loopCtrl()中除编码器读取和占空比设置外的部分
+        STAGE_SET_DUTY,          // 占空比写入 BLDC_Driver_DRV8300::set_compare()
+        STAGE_TOTAL,             // 整个电流环中断回调
+        STAGE_NUM
+    };
+
+    static constexpr const char *STAGE_NAMES[STAGE_NUM] = {
+        "current_sense",
+        "encoder_read",
+        "transform_pid",
+        "set_duty",
+        "total",
+    };
+
+    // 直方图区间数, 区间0为[0,64)个周期, 区间i为[2^(i+5),2^(i+6))个周期, 最后一个区间无上界
+    static constexpr uint8_t HIST_BINS = 10;
+
+    struct Statistics {
+        uint32_t min;
+        uint32_t max;
+        uint64_t sum;
+        uint32_t count;
+        uint32_t hist[HIST_BINS];
+
+        [[nodiscard]] uint32_t mean() const { return count ? static_cast<uint32_t>(sum / count) : 0; }
+
+        static uint32_t bin_lower(const uint8_t bin) { return bin == 0 ? 0 : 1U << (bin + 5); }
+    };
+
+    /**
+     * @brief 初始化DWT周期计数器并清空统计
+     * @param budget_cycles 每个电流环周期可用的CPU周期数
+     */
+    static void init(const uint32_t budget_cycles) {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+        budget = budget_cycles;
+        reset();
+    }
+
+    [[nodiscard]] static uint32_t get_budget() { return budget; }
+
+    static uint32_t now() { return DWT->CYCCNT; }
+
+    /**
+     * @brief 开始记录本次电流环中断,需在中断开头调用,与commit()成对
+     */
+    static void begin() {
+        marked = 0;
+        active = true;
+    }
+
+    /**
+     * @brief 暂存某阶段本次耗时,在commit()时计入统计;不在begin()与commit()之间时丢弃
+     * @param stage 阶段
+     * @param cycles 耗时,单位CPU周期
+     */
+    static void mark(const Stage stage, const uint32_t cycles) {
+        if (!active) return;
+        last[stage] = cycles;
+        marked |= 1U << stage;
+    }
+
+    /**
+     * @brief 将本次中断内暂存的各阶段耗时计入统计
+     * @note 需在电流环中断末尾调用,STAGE_TRANSFORM_PID由总耗时扣除其余阶段得到
+     */
+    static void commit() {
+        if (marked & 1U << STAGE_TOTAL) {
+            uint32_t rest = last[STAGE_TOTAL];
+            for (const auto stage : {STAGE_CURRENT_SENSE, STAGE_ENCODER_READ, STAGE_SET_DUTY})
+                if (marked & 1U << stage) rest -= std::min(rest, last[stage]);
+            mark(STAGE_TRANSFORM_PID, rest);
+        }
+        for (uint8_t stage = 0; stage < STAGE_NUM; ++stage)
+            if (marked & 1U << stage) accumulate(stats[stage], last[stage]);
+        marked = 0;
+        active = false;
+    }
+
+    /**
+     * @brief 获取某阶段统计数据的一致副本
+     */
+    static Statistics snapshot(const Stage stage) {
+        const uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        const Statistics copy = stats[stage];
+        __set_PRIMASK(primask);
+        return copy;
+    }
+
+    static void reset() {
+        const uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        for (auto& stat : stats) stat = {UINT32_MAX, 0, 0, 0, {}};
+        marked = 0;
+        __set_PRIMASK(primask);
+    }
+
+    /**
+     * @brief 作用域计时器,析构时暂存所在阶段的耗时
+     */
+    class Scope {
+    public:
+        explicit Scope(const Stage stage) : stage(stage), start(now()) {}
+        ~Scope() { mark(stage, now() - start); }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        const Stage stage;
+        const uint32_t start;
+    };
+
+private:
+    inline static Statistics stats[STAGE_NUM]{};
+    inline static uint32_t last[STAGE_NUM]{};
+    inline static uint32_t marked{0};
+    inline static volatile bool active{false}; // 处于begin()与commit()之间,只在电流环中断中修改
+    inline static uint32_t budget{0};
+
+    static void accumulate(Statistics& stat, const uint32_t cycles) {
+        stat.min = std::min(stat.min, cycles);
+        stat.max = std::max(stat.max, cycles);
+        stat.sum += cycles;
+        ++stat.count;
+        const uint32_t msb = 31 - __CLZ(cycles | 1U);
+        ++stat.hist[std::min<uint32_t>(msb > 5 ? msb - 5 : 0, HIST_BINS - 1)];
+    }
+};
@@ -0,0 +1,120 @@
+/**
+ * @brief 		DeadlineMonitor.h库文件
+ * @detail      使用DWT周期计数器监测控制中断(电流环ADC注入中断、速度环位置环TIM6中断)的实时性:
+ *              相邻两次中断的间隔、触发到进入中断的延迟、触发到退出中断的总耗时,以及超时次数
+ * @author 	    Haoqi Liu
+ * @date        26-10-17
+ * @version 	V1.0.0
+ * @note 		超时分两类统计:
+ *              overrun: 触发延迟+中断执行时间超过控制周期,即下一次触发到来时本次中断仍在执行
+ *              missed : 相邻两次中断间隔超过1.5个控制周期,按间隔折算丢失的周期数
+ * @warning	    依赖DWT_Profiler::init()开启DWT周期计数器
+ * @par 		历史版本
+                V1.0.0创建于26-10-17
+ * */
+
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+#include "main.h"
+#include "DWT_Profiler.h"
+
+class DeadlineMonitor {
+public:
+    enum Channel : uint8_t {
+        CHANNEL_CURRENT_LOOP = 0, // 电流环,ADC注入转换完成中断
+        CHANNEL_CTRL_LOOP,        // 速度环位置环,TIM6更新中断
+        CHANNEL_NUM
+    };
+
+    static constexpr const char *CHANNEL_NAMES[CHANNEL_NUM] = {
+        "current_loop",
+        "ctrl_loop",
+    };
+
+    struct Statistics {
+        uint32_t period;       // 控制周期,单位CPU周期
+        uint32_t max_interval; // 最大中断间隔,单位CPU周期
+        uint32_t max_latency;  // 最大触发延迟,单位CPU周期
+        uint32_t max_busy;     // 最大触发到退出中断的耗时,单位CPU周期
+        uint32_t overruns;     // 本次中断未在下一次触发前结束的次数
+        uint32_t missed;       // 丢失的控制周期数
+        uint32_t count;        // 中断次数
+    };
+
+    /**
+     * @brief 设置通道的控制周期并清空统计
+     * @param channel 通道
+     * @param period_cycles 控制周期,单位CPU周期
+     */
+    static void init(const Channel channel, const uint32_t period_cycles) {
+        const uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        stats[channel] = {period_cycles, 0, 0, 0, 0, 0, 0};
+        entry[channel] = 0;
+        __set_PRIMASK(primask);
+    }
+
+    /**
+     * @brief 进入中断时调用
+     * @param channel 通道
+     * @param latency_cycles 触发到进入中断的延迟,单位CPU周期,由调用者根据触发定时器的计数值换算
+     */
+    static void enter(const Channel channel, const uint32_t latency_cycles) {
+        const uint32_t now = DWT_Profiler::now();
+        Statistics& stat = stats[channel];
+        if (stat.count != 0) {
+            const uint32_t interval = now - entry[channel];
+            stat.max_interval = std::max(stat.max_interval, interval);
+            if (2 * interval > 3 * stat.period)
+                stat.missed += (interval + stat.period / 2) / stat.period - 1;
+        }
+        ++stat.count;
+        entry[channel] = now;
+        latency[channel] = latency_cycles;
+        stat.max_latency = std::max(stat.max_latency, latency_cycles);
+    }
+
+    /**
+     * @brief 退出中断时调用
+     */
+    static void exit(const Channel channel) {
+        Statistics& stat = stats[channel];
+        const uint32_t busy = latency[channel] + (DWT_Profiler::now() - entry[channel]);
+        stat.max_busy = std::max(stat.max_busy, busy);
+        if (busy > stat.period) ++stat.overruns;
+    }
+
+    /**
+     * @brief 所有通道的超时总数(overrun+missed),用于判断是否有新的超时
+     */
+    static uint32_t violations() {
+        uint32_t sum = 0;
+        for (const auto& stat : stats) sum += stat.overruns + stat.missed;
+        return sum;
+    }
+
+    /**
+     * @brief 获取某通道统计数据的一致副本
+     */
+    static Statistics snapshot(const Channel channel) {
+        const uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        const Statistics copy = stats[channel];
+        __set_PRIMASK(primask);
+        return copy;
+    }
+
+    static void reset() {
+        const uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        for (auto& stat : stats) stat = {stat.period, 0, 0, 0, 0, 0, 0};
+        __set_PRIMASK(primask);
+    }
+
+private:
+    inline static Statistics stats[CHANNEL_NUM]{};
+    inline static uint32_t entry[CHANNEL_NUM]{};   // 本次进入中断的时刻
+    inline static uint32_t latency[CHANNEL_NUM]{}; // 本次触发延迟
+};
@@ -0,0 +1,102 @@
+/**
+ * @brief 		Encoder_Compensated.h库文件
+ * @detail      编码器延迟补偿: 按转速把角度外推"采样到PWM生效"的延迟,减小高电角速度下的换相相位滞后
+ * @author 	    Haoqi Liu
+ * @date        26-10-17
+ * @version 	V1.1.0
+ * @note 		包装任意Encoder,get_angle()返回 θ + ω·delay;
+ *              ω取自外部提供的滤波后转速(如QD4310::getSpeed()),delay由set_delay()给定,
+ *              或在每个电流环周期以calibrate()输入实测延迟,内部一阶低通平滑
+ *              14对极、1000rpm时电角速度约1466rad/s,50us延迟对应约4.2°电角度滞后;
+ *              extrapolate_next()使下一次get_angle()不读取编码器,由上一次读数按转速外推,
+ *              供电流环倍频时没有编码器采样的半周期使用
+ * @warning	    未设置转速来源时不做补偿
+ * @par 		历史版本
+                V1.0.0创建于26-10-17
+                V1.1.0创建于26-10-17, 添加extrapolate_next(),跳过一次编码器读取
+ * */
+
+#pragma once
+
+#include <numbers>
+#include "Encoder.h"
+
+class Encoder_Compensated final : public Encoder {
+public:
+    bool compensation = true; // 是否启用补偿
+
+    ~Encoder_Compensated() override = default;
+
+    /**
+     * @param encoder 被补偿的编码器
+     * @param delay 初始延迟,单位s
+     */
+    explicit Encoder_Compensated(Encoder& encoder, const float delay = 0.0f) :
+        encoder(encoder), delay(delay) {}
+
+    void init() override {
+        encoder.init();
+        resolution = encoder.resolution;
+        initialized = encoder.initialized;
+    }
+
+    void enable() override {
+        encoder.enable();
+        enabled = encoder.enabled;
+    }
+
+    void disable() override {
+        encoder.disable();
+        enabled = encoder.enabled;
+    }
+
+    float get_angle() override {
+        float angle, advance = delay;
+        if (extrapolating) {
+            extrapolating = false;
+            angle = last_angle;
+            advance += elapsed;
+        } else angle = last_angle = encoder.get_angle();
+        if (!compensation || speed_source == nullptr) return angle;
+        angle += speed_source() * advance;
+        // 补偿量远小于一圈,一次加减即可回到[0,2pi)
+        if (angle >= 2 * std::numbers::pi_v<float>) angle -= 2 * std::numbers::pi_v<float>;
+        else if (angle < 0) angle += 2 * std::numbers::pi_v<float>;
+        return angle;
+    }
+
+    /**
+     * @brief 设置转速来源
+     * @param source 返回滤波后的机械角速度,单位rad/s
+     */
+    void set_speed_source(float (*source)()) { speed_source = source; }
+
+    void set_delay(const float seconds) { delay = seconds; }
+
+    [[nodiscard]] float get_delay() const { return delay; }
+
+    /**
+     * @brief 输入一次实测的"采样到PWM生效"延迟,低通平滑后作为补偿延迟
+     * @param seconds 实测延迟,单位s
+     */
+    void calibrate(const float seconds) { delay += (seconds - delay) * CALIBRATION_ALPHA; }
+
+    /**
+     * @brief 下一次get_angle()不读取编码器,返回上一次读数外推elapsed后的角度(未设置转速来源时不外推)
+     * @param seconds 距上一次编码器采样的时间,单位s
+     */
+    void extrapolate_next(const float seconds) {
+        elapsed = seconds;
+        extrapolating = true;
+    }
+
+private:
+    static constexpr float CALIBRATION_ALPHA = 0.001f; // 20kHz下时间常数约50ms
+
+    Encoder& encoder;
+    float delay;                       // 补偿延迟,单位s
+    float last_angle{};                // 上一次编码器读数,单位rad
+    float elapsed{};                   // 外推时距上一次编码器采样的时间,单位s
+    bool extrapolating{false};         // 下一次get_angle()外推而不读取编码器
+    float (*speed_source)() = nullptr; // 转速来源,单位rad/s
+};
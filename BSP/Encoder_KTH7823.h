@@ -2,15 +2,18 @@
  * @brief   Encoder KTH7823 Version
  * @details
  * @author  Haoqi Liu
- * @date    2026-6-114
- * @version V3.1.0
- * @note
+ * @date    2026-10-17
+ * @version V3.2.0
+ * @note    默认使用寄存器级读取(SPI_Fast),可通过read_path切换为HAL读取;
+ *          每帧都需要片选脉冲,不支持定时器触发的DMA读取
  * @warning
  * @par     历史版本:
 		    V1.0.0创建于2024-7-3
 		    V2.0.0 on 2025-1-20,refactor by C++
 		    V3.0.0 on 2025-4-16,delete ZeroPosition_Calibration and put it in FOC Class
 		    V3.1.0 on 2026-6-14,add resolution
+		    V3.1.1 on 2026-10-17,add DWT profiling of get_angle
+		    V3.2.0 on 2026-10-17,add register level read path and read path selection
  * @copyright   (c) 2026 QDrive
  * */
 
@@ -19,11 +22,15 @@
 
 #include <numbers>
 #include "Encoder.h"
+#include "DWT_Profiler.h"
+#include "SPI_Fast.h"
 #include "spi.h"
 #include "gpio.h"
 
 class Encoder_KTH7823 final : public Encoder {
 public:
+    SPI_ReadPath read_path = SPI_ReadPath::REGISTER; // 角度读取方式,DMA按REGISTER处理
+
     ~Encoder_KTH7823() override = default;
 
     Encoder_KTH7823(GPIO_TypeDef *CS_GPIO_Port,
@@ -54,13 +61,21 @@ public:
     }
 
     float get_angle() override {
+        DWT_Profiler::Scope profile(DWT_Profiler::STAGE_ENCODER_READ);
         static uint16_t rxData;
         static uint16_t txData = 0x0000;
         if (!enabled) return 0;
-        HAL_GPIO_WritePin(CS_GPIO_Port, CS_GPIO_Pin, GPIO_PIN_RESET);
-        HAL_SPI_TransmitReceive(hspi, reinterpret_cast<uint8_t *>(&txData),
-                                reinterpret_cast<uint8_t *>(&rxData), 1, 100);
-        HAL_GPIO_WritePin(CS_GPIO_Port, CS_GPIO_Pin, GPIO_PIN_SET);
+        if (read_path == SPI_ReadPath::HAL) {
+            HAL_GPIO_WritePin(CS_GPIO_Port, CS_GPIO_Pin, GPIO_PIN_RESET);
+            HAL_SPI_TransmitReceive(hspi, reinterpret_cast<uint8_t *>(&txData),
+                                    reinterpret_cast<uint8_t *>(&rxData), 1, 100);
+            HAL_GPIO_WritePin(CS_GPIO_Port, CS_GPIO_Pin, GPIO_PIN_SET);
+        } else {
+            SPI_Fast::select(CS_GPIO_Port, CS_GPIO_Pin);
+            SPI_Fast::transfer(hspi->Instance, reinterpret_cast<uint8_t *>(&txData),
+                               reinterpret_cast<uint8_t *>(&rxData), 1);
+            SPI_Fast::deselect(CS_GPIO_Port, CS_GPIO_Pin);
+        }
         return rxData * resolution; //转化为弧度制
     }
 
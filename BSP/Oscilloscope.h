@@ -0,0 +1,323 @@
+/**
+ * @brief 		Oscilloscope.h库文件
+ * @detail      以电流环频率(20kHz)把电流、占空比、电角度、转速和母线电压记录到RAM环形缓冲区,
+ *              支持阈值/控制模式切换触发及预触发,采集完成后以二进制帧输出
+ * @author 	    Haoqi Liu
+ * @date        26-10-17
+ * @version 	V1.1.0
+ * @note 		中断中只保存原始量(相电流、占空比、电角度),Id/Iq/Ud/Uq的坐标变换在dump()中完成,
+ *              以减少电流环中断的额外开销
+ * @warning	    record()只能在电流环中断中调用,arm()/force()/stop()/dump()在任务中调用
+ * @par 		历史版本
+                V1.0.0创建于26-10-17
+                V1.0.1创建于26-10-17, 帧校验改用查表法CRC8
+                V1.1.0创建于26-10-17, 添加采集结果的电流均值和标准差统计,用于对比电流采样噪声
+ * */
+
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <numbers>
+#include <algorithm>
+#include "main.h"
+#include "CRC8.h"
+
+class Oscilloscope {
+public:
+    static constexpr uint16_t DEPTH = 256; // 缓冲区深度,单位采样点
+
+    // 触发源
+    enum Trigger : uint8_t {
+        TRIGGER_NONE = 0,   // 无触发,需force()手动触发
+        TRIGGER_IQ_RISE,    // Q轴电流上穿阈值
+        TRIGGER_IQ_FALL,    // Q轴电流下穿阈值
+        TRIGGER_SPEED_RISE, // 转速上穿阈值
+        TRIGGER_SPEED_FALL, // 转速下穿阈值
+        TRIGGER_MODE,       // 控制模式切换
+        TRIGGER_NUM
+    };
+
+    static constexpr const char *TRIGGER_NAMES[TRIGGER_NUM] = {
+        "none",
+        "iq_rise",
+        "iq_fall",
+        "speed_rise",
+        "speed_fall",
+        "mode",
+    };
+
+    enum State : uint8_t {
+        STATE_IDLE = 0,  // 未启动
+        STATE_ARMED,     // 预触发采集中,等待触发
+        STATE_TRIGGERED, // 已触发,后触发采集中
+        STATE_DONE,      // 采集完成,可读取
+    };
+
+    // 中断中保存的原始采样
+    struct Sample {
+        int16_t iu;       // U相电流,-10A~10A映射到int16
+        int16_t iv;       // V相电流,-10A~10A映射到int16
+        uint16_t theta_e; // 电角度,0~2pi映射到uint16
+        uint16_t duty_u;  // U相占空比,0~1映射到uint16
+        uint16_t duty_v;  // V相占空比,0~1映射到uint16
+        uint16_t duty_w;  // W相占空比,0~1映射到uint16
+        int16_t speed;    // 转速,-1k~1krpm映射到int16
+        uint16_t vbus;    // 母线电压,单位mV
+    };
+
+    // 触发判断用的实时量
+    struct Probe {
+        float iq;     // Q轴电流,单位A
+        float speed;  // 转速,单位rpm
+        uint8_t mode; // 控制模式
+    };
+
+    // 输出帧格式: 0xA5 0x5A | type | seq(2) | len | payload(len) | CRC8
+    enum FrameType : uint8_t {
+        FRAME_INFO = 0x01, // 采集信息
+        FRAME_DATA = 0x02, // 采样数据
+        FRAME_END = 0x03,  // 结束
+    };
+
+    static constexpr uint8_t SIGNAL_NUM = 7;           // 每个采样点输出的信号数: Iq Id Uq Ud theta_e speed Vbus
+    static constexpr uint8_t SAMPLES_PER_FRAME = 8;    // 每个数据帧包含的采样点数
+    static constexpr uint8_t FRAME_OVERHEAD = 7;       // 帧头、类型、序号、长度和CRC8的字节数
+    static constexpr uint8_t MAX_PAYLOAD = SAMPLES_PER_FRAME * SIGNAL_NUM * sizeof(int16_t);
+
+    static int16_t to_current(const float i) { return saturate(i / 10 * INT16_MAX); }
+    static int16_t to_speed(const float n) { return saturate(n / 1000 * INT16_MAX); }
+
+    static uint16_t to_angle(const float theta) {
+        return static_cast<uint16_t>(static_cast<int32_t>(theta / (2 * std::numbers::pi_v<float>) * 65536.0f));
+    }
+
+    static uint16_t to_duty(const float duty) {
+        return static_cast<uint16_t>(std::clamp(duty, 0.0f, 1.0f) * UINT16_MAX);
+    }
+
+    static uint16_t to_voltage(const float v) { return static_cast<uint16_t>(std::clamp(v * 1000, 0.0f, 65535.0f)); }
+
+    /**
+     * @brief 启动采集
+     * @param trigger 触发源
+     * @param level 触发阈值,单位与触发源对应(A或rpm)
+     * @param pre_samples 预触发采样点数
+     * @param decimation 抽取比,每decimation个电流环周期记录一个点
+     */
+    static void arm(const Trigger trigger, const float level, const uint16_t pre_samples, const uint16_t decimation) {
+        state = STATE_IDLE;
+        cfg_trigger = trigger;
+        cfg_level = level;
+        cfg_pre = std::min<uint16_t>(pre_samples, DEPTH - 1);
+        cfg_decimation = std::max<uint16_t>(decimation, 1);
+        head = 0;
+        filled = 0;
+        post = 0;
+        divider = 0;
+        first = true;
+        state = STATE_ARMED;
+    }
+
+    // 手动触发
+    static void force() {
+        if (state == STATE_ARMED) forced = true;
+    }
+
+    static void stop() { state = STATE_IDLE; }
+
+    [[nodiscard]] static State get_state() { return state; }
+    [[nodiscard]] static bool is_recording() { return state == STATE_ARMED || state == STATE_TRIGGERED; }
+    [[nodiscard]] static Trigger get_trigger() { return cfg_trigger; }
+    [[nodiscard]] static float get_level() { return cfg_level; }
+    [[nodiscard]] static uint16_t get_pre() { return cfg_pre; }
+    [[nodiscard]] static uint16_t get_decimation() { return cfg_decimation; }
+    [[nodiscard]] static uint16_t get_filled() { return filled; }
+
+    /**
+     * @brief 记录一个采样点,在电流环中断末尾调用
+     * @param sample 原始采样
+     * @param probe 触发判断用的实时量
+     */
+    static void record(const Sample& sample, const Probe& probe) {
+        if (!is_recording()) return;
+        if (++divider < cfg_decimation) return;
+        divider = 0;
+
+        buffer[head] = sample;
+        head = (head + 1) % DEPTH;
+        if (filled < DEPTH) ++filled;
+
+        if (state == STATE_ARMED) {
+            // 预触发数据采满后才允许触发
+            if (filled > cfg_pre && (forced || triggered(probe))) {
+                forced = false;
+                state = STATE_TRIGGERED;
+                post = DEPTH - cfg_pre - 1;
+                if (post == 0) state = STATE_DONE;
+            }
+        } else if (--post == 0) {
+            state = STATE_DONE;
+        }
+        last = probe;
+        first = false;
+    }
+
+    /**
+     * @brief 以二进制帧输出采集结果
+     * @param write 发送函数,返回false表示发送失败
+     * @param sample_rate 记录频率(抽取前),单位Hz
+     * @return 全部帧发送成功返回true
+     */
+    template <typename WriteFunc>
+    static bool dump(WriteFunc&& write, const uint32_t sample_rate) {
+        if (state != STATE_DONE) return false;
+        uint16_t seq = 0;
+
+        // 采集信息帧: 采样点数(2) 触发点下标(2) 采样频率(4) 触发源(1) 信号数(1)
+        uint8_t info[10];
+        const uint32_t rate = sample_rate / cfg_decimation;
+        put16(&info[0], DEPTH);
+        put16(&info[2], cfg_pre);
+        put16(&info[4], rate & 0xFFFF);
+        put16(&info[6], rate >> 16 & 0xFFFF);
+        info[8] = cfg_trigger;
+        info[9] = SIGNAL_NUM;
+        if (!send_frame(write, FRAME_INFO, seq++, info, sizeof(info))) return false;
+
+        // 数据帧: 每个采样点依次为Iq Id Uq Ud theta_e speed Vbus,各2字节,小端
+        // Iq/Id: -10A~10A映射到int16, Uq/Ud: 单位mV, theta_e: 0~2pi映射到uint16, speed: -1k~1krpm映射到int16, Vbus: 单位mV
+        uint8_t payload[MAX_PAYLOAD];
+        uint8_t len = 0;
+        for (uint16_t i = 0; i < DEPTH; ++i) {
+            const Sample& s = buffer[(head + i) % DEPTH]; // 最早的采样点位于head处
+            int16_t out[SIGNAL_NUM];
+            transform(s, out);
+            for (const int16_t value : out) {
+                put16(&payload[len], static_cast<uint16_t>(value));
+                len += 2;
+            }
+            if (len == MAX_PAYLOAD || i == DEPTH - 1) {
+                if (!send_frame(write, FRAME_DATA, seq++, payload, len)) return false;
+                len = 0;
+            }
+        }
+        return send_frame(write, FRAME_END, seq, nullptr, 0);
+    }
+
+    // 电流统计,单位A
+    struct CurrentStatistics {
+        float mean[4]; // 依次为Iu Iv Iq Id
+        float std[4];  // 标准差,静止且电流为0时即为电流采样噪声
+    };
+
+    /**
+     * @brief 统计采集结果中各电流的均值和标准差
+     * @param stat 统计结果
+     * @return 没有采集结果时返回false
+     */
+    static bool statistics(CurrentStatistics& stat) {
+        if (state != STATE_DONE) return false;
+        constexpr float I_SCALE = 10.0f / INT16_MAX;
+        auto current = [](const Sample& s, float (&i)[4]) {
+            int16_t out[SIGNAL_NUM];
+            transform(s, out);
+            i[0] = static_cast<float>(s.iu) * I_SCALE;
+            i[1] = static_cast<float>(s.iv) * I_SCALE;
+            i[2] = static_cast<float>(out[0]) * I_SCALE;
+            i[3] = static_cast<float>(out[1]) * I_SCALE;
+        };
+        // 先求均值再求方差,避免单精度下大均值时的抵消误差
+        float sum[4]{}, sum_sq[4]{}, i[4];
+        for (const Sample& s : buffer) {
+            current(s, i);
+            for (uint8_t k = 0; k < 4; ++k) sum[k] += i[k];
+        }
+        for (uint8_t k = 0; k < 4; ++k) stat.mean[k] = sum[k] / DEPTH;
+        for (const Sample& s : buffer) {
+            current(s, i);
+            for (uint8_t k = 0; k < 4; ++k) sum_sq[k] += (i[k] - stat.mean[k]) * (i[k] - stat.mean[k]);
+        }
+        for (uint8_t k = 0; k < 4; ++k) stat.std[k] = std::sqrt(sum_sq[k] / DEPTH);
+        return true;
+    }
+
+private:
+    inline static Sample buffer[DEPTH]{};
+    inline static volatile State state{STATE_IDLE};
+    inline static volatile bool forced{false};
+    inline static Trigger cfg_trigger{TRIGGER_NONE};
+    inline static float cfg_level{0.0f};
+    inline static uint16_t cfg_pre{DEPTH / 4};
+    inline static uint16_t cfg_decimation{1};
+    inline static uint16_t head{0};     // 下一个写入位置
+    inline static uint16_t filled{0};   // 已写入的采样点数
+    inline static uint16_t post{0};     // 剩余后触发采样点数
+    inline static uint16_t divider{0};  // 抽取计数
+    inline static Probe last{};         // 上一个采样点的实时量,用于边沿判断
+    inline static bool first{true};     // 是否为启动后的第一个采样点
+
+    static int16_t saturate(const float x) {
+        return static_cast<int16_t>(std::clamp(x, static_cast<float>(INT16_MIN), static_cast<float>(INT16_MAX)));
+    }
+
+    static void put16(uint8_t *dst, const uint16_t value) {
+        dst[0] = value & 0xFF;
+        dst[1] = value >> 8;
+    }
+
+    [[nodiscard]] static bool triggered(const Probe& probe) {
+        if (first) return false;
+        switch (cfg_trigger) {
+            case TRIGGER_IQ_RISE: return last.iq < cfg_level && probe.iq >= cfg_level;
+            case TRIGGER_IQ_FALL: return last.iq > cfg_level && probe.iq <= cfg_level;
+            case TRIGGER_SPEED_RISE: return last.speed < cfg_level && probe.speed >= cfg_level;
+            case TRIGGER_SPEED_FALL: return last.speed > cfg_level && probe.speed <= cfg_level;
+            case TRIGGER_MODE: return last.mode != probe.mode;
+            default: return false;
+        }
+    }
+
+    /**
+     * @brief 由原始采样计算输出信号
+     */
+    static void transform(const Sample& s, int16_t (&out)[SIGNAL_NUM]) {
+        constexpr float I_SCALE = 10.0f / INT16_MAX;
+        constexpr float D_SCALE = 1.0f / UINT16_MAX;
+        const float theta = static_cast<float>(s.theta_e) * (2 * std::numbers::pi_v<float> / 65536.0f);
+        const float c = std::cos(theta), sn = std::sin(theta);
+        const float vbus = static_cast<float>(s.vbus) * 1e-3f;
+
+        // Clarke-Park变换(等幅值)
+        const float i_alpha = static_cast<float>(s.iu) * I_SCALE;
+        const float i_beta = (static_cast<float>(s.iu) + 2 * static_cast<float>(s.iv)) * I_SCALE /
+                             std::numbers::sqrt3_v<float>;
+        const float du = static_cast<float>(s.duty_u) * D_SCALE;
+        const float dv = static_cast<float>(s.duty_v) * D_SCALE;
+        const float dw = static_cast<float>(s.duty_w) * D_SCALE;
+        const float u_alpha = vbus * (2 * du - dv - dw) / 3;
+        const float u_beta = vbus * (dv - dw) / std::numbers::sqrt3_v<float>;
+
+        out[0] = to_current(-sn * i_alpha + c * i_beta);                  // Iq
+        out[1] = to_current(c * i_alpha + sn * i_beta);                   // Id
+        out[2] = saturate((-sn * u_alpha + c * u_beta) * 1000);           // Uq,单位mV
+        out[3] = saturate((c * u_alpha + sn * u_beta) * 1000);            // Ud,单位mV
+        out[4] = static_cast<int16_t>(s.theta_e);                         // theta_e
+        out[5] = s.speed;                                                 // speed
+        out[6] = static_cast<int16_t>(s.vbus);                            // Vbus
+    }
+
+    template <typename WriteFunc>
+    static bool send_frame(WriteFunc& write, const FrameType type, const uint16_t seq,
+                           const uint8_t *payload, const uint8_t len) {
+        uint8_t frame[MAX_PAYLOAD + FRAME_OVERHEAD];
+        frame[0] = 0xA5;
+        frame[1] = 0x5A;
+        frame[2] = type;
+        put16(&frame[3], seq);
+        frame[5] = len;
+        std::copy_n(payload, len, &frame[6]);
+        frame[6 + len] = CRC8_Protocol::compute(frame, 6 + len);
+        return write(frame, static_cast<uint16_t>(len + FRAME_OVERHEAD));
+    }
+};
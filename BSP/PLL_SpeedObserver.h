@@ -0,0 +1,63 @@
+/**
+ * @brief 		PLL_SpeedObserver.h库文件
+ * @detail      锁相环(PLL)速度观测器,作为速度滤波器接入QDrive,替代"角度差分+二阶低通"
+ * @author 	    Haoqi Liu
+ * @date        26-10-17
+ * @version 	V1.0.0
+ * @note 		输入为每个周期的角度差分速度 ω_raw=Δθ/Ts,对 (ω_raw-ω̂)·Ts 积分即得到角度跟踪误差 e=θ-θ̂,
+ *              无需绝对角度,也不受角度回绕影响;PI校正 ω̂ = Kp·e + Ki·∫e,
+ *              临界阻尼二阶环: Kp=2ωn, Ki=ωn², ωn=2π·带宽
+ *              二型环对匀速(角度斜坡)无稳态误差,相比低通滤波没有匀速时的群延迟
+ * @warning	    输入输出单位一致即可(rpm或rad/s);带宽需远小于采样频率
+ * @par 		历史版本
+                V1.0.0创建于26-10-17
+ * */
+
+#pragma once
+
+#include <numbers>
+#include "filters.h"
+
+class PLL_SpeedObserver final : public Filter {
+public:
+    /**
+     * @param Ts 采样周期,单位s
+     * @param bandwidth 带宽,单位Hz
+     */
+    PLL_SpeedObserver(const float Ts, const float bandwidth) : Ts(Ts) {
+        set_bandwidth(bandwidth);
+    }
+
+    float operator()(const float input) override {
+        error += (input - speed) * Ts;
+        integral += ki * error * Ts;
+        speed = integral + kp * error;
+        return speed;
+    }
+
+    /**
+     * @brief 设置带宽
+     * @param hz 带宽,单位Hz,范围(0, 采样频率/20]
+     * @return 超出范围返回false
+     */
+    bool set_bandwidth(const float hz) {
+        if (!(hz > 0 && hz * Ts <= 0.05f)) return false;
+        const float wn = 2 * std::numbers::pi_v<float> * hz;
+        kp = 2 * wn;
+        ki = wn * wn;
+        bandwidth = hz;
+        return true;
+    }
+
+    [[nodiscard]] float get_bandwidth() const { return bandwidth; }
+
+    [[nodiscard]] float get_error() const { return error; } // 角度跟踪误差,单位为输入单位·s
+
+private:
+    const float Ts;
+    float bandwidth{};
+    float kp{}, ki{};
+    float error{0.0f};    // 角度跟踪误差
+    float integral{0.0f}; // 积分项,即速度的低频部分
+    float speed{0.0f};    // 速度估计
+};
@@ -0,0 +1,97 @@
+/**
+ * @brief 		SPI_Fast.h库文件
+ * @detail      寄存器级阻塞SPI收发,绕过HAL_SPI的句柄锁、状态检查和超时计时,用于控制中断中的编码器读取
+ * @author 	    Haoqi Liu
+ * @date        26-10-17
+ * @version 	V1.0.1
+ * @note 		数据帧宽度沿用SPI配置: 8位帧时以16位访问DR,一次写入两帧(数据打包),
+ *              接收仍按字节读取(FRXTH=1,与HAL配置一致);16位帧时每次访问一帧;
+ *              收发结果与HAL_SPI_TransmitReceive相同,发送缓冲区为nullptr时发送0
+ * @note        不修改帧宽度和分频: DS只能在SPE=0时修改,同一SPI上的HAL和DMA读取都按8位帧配置,
+ *              每次读取切换帧宽度的开销比省下的DR访问更大,而8位帧打包后DR写入次数已与16位帧相同;
+ *              SPI1时钟为170MHz/16=10.6MHz,下一档8分频为21.25MHz,超过MT6826S/MT6825的16MHz上限
+ * @warning	    无超时,SPI必须已由HAL初始化;不能与DMA传输同时进行
+ * @par 		历史版本
+                V1.0.0创建于26-10-17
+                V1.0.1创建于26-10-17, 注明沿用SPI帧宽度和分频的原因
+ * */
+
+#pragma once
+
+#include <cstdint>
+#include "main.h"
+
+class SPI_Fast {
+public:
+    /**
+     * @brief 8位帧收发
+     * @param spi SPI外设
+     * @param tx 发送数据,可为nullptr
+     * @param rx 接收数据,可与tx相同
+     * @param size 帧数
+     */
+    static void transfer8(SPI_TypeDef *spi, const uint8_t *tx, uint8_t *rx, const uint16_t size) {
+        if (!(spi->CR1 & SPI_CR1_SPE)) spi->CR1 |= SPI_CR1_SPE;
+        uint16_t sent = 0, received = 0;
+        while (received < size) {
+            // FIFO为32位,在途数据不超过4帧,保证接收FIFO不会溢出
+            if (sent < size && spi->SR & SPI_SR_TXE) {
+                if (size - sent >= 2 && sent - received <= 2) {
+                    const uint16_t data = tx ? tx[sent] | tx[sent + 1] << 8 : 0;
+                    *reinterpret_cast<__IO uint16_t *>(&spi->DR) = data; // 低字节先发送
+                    sent += 2;
+                } else if (sent - received < 4) {
+                    *reinterpret_cast<__IO uint8_t *>(&spi->DR) = tx ? tx[sent] : 0;
+                    ++sent;
+                }
+            }
+            if (spi->SR & SPI_SR_RXNE) rx[received++] = *reinterpret_cast<__IO uint8_t *>(&spi->DR);
+        }
+    }
+
+    /**
+     * @brief 16位帧收发
+     * @param spi SPI外设
+     * @param tx 发送数据,可为nullptr
+     * @param rx 接收数据,可与tx相同
+     * @param size 帧数
+     */
+    static void transfer16(SPI_TypeDef *spi, const uint16_t *tx, uint16_t *rx, const uint16_t size) {
+        if (!(spi->CR1 & SPI_CR1_SPE)) spi->CR1 |= SPI_CR1_SPE;
+        uint16_t sent = 0, received = 0;
+        while (received < size) {
+            if (sent < size && sent - received < 2 && spi->SR & SPI_SR_TXE) {
+                *reinterpret_cast<__IO uint16_t *>(&spi->DR) = tx ? tx[sent] : 0;
+                ++sent;
+            }
+            if (spi->SR & SPI_SR_RXNE) rx[received++] = *reinterpret_cast<__IO uint16_t *>(&spi->DR);
+        }
+    }
+
+    /**
+     * @brief 按SPI当前配置的帧宽度收发,与HAL_SPI_TransmitReceive的Size含义一致
+     */
+    static void transfer(SPI_TypeDef *spi, const uint8_t *tx, uint8_t *rx, const uint16_t size) {
+        if ((spi->CR2 & SPI_CR2_DS) > SPI_DATASIZE_8BIT)
+            transfer16(spi, reinterpret_cast<const uint16_t *>(tx), reinterpret_cast<uint16_t *>(rx), size);
+        else
+            transfer8(spi, tx, rx, size);
+    }
+
+    /**
+     * @brief 片选拉低,直接写BSRR
+     */
+    static void select(GPIO_TypeDef *port, const uint16_t pin) { port->BSRR = static_cast<uint32_t>(pin) << 16; }
+
+    /**
+     * @brief 片选拉高,直接写BSRR
+     */
+    static void deselect(GPIO_TypeDef *port, const uint16_t pin) { port->BSRR = pin; }
+};
+
+// 编码器的SPI读取方式
+enum class SPI_ReadPath : uint8_t {
+    DMA,      // 定时器触发的DMA读取(SPI_TriggeredRead),未绑定触发源时按REGISTER读取
+    REGISTER, // 寄存器级阻塞读取(SPI_Fast)
+    HAL,      // HAL_SPI阻塞读取
+};
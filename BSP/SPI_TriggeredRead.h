@@ -0,0 +1,139 @@
+/**
+ * @brief 		SPI_TriggeredRead.h库文件
+ * @detail      由定时器DMA请求启动的SPI DMA读取: 定时器事件到来时由一个DMA通道向SPI CR2写入TXDMAEN,
+ *              SPI随即以DMA收发固定长度的数据,CPU不参与传输过程
+ * @author 	    Haoqi Liu
+ * @date        26-10-17
+ * @version 	V1.1.0
+ * @note 		使用三个DMA通道: SPI接收、SPI发送(发送0x00)、触发(循环模式,每次定时器请求写一次CR2);
+ *              每次读取后需调用arm()重新装填,未装填时触发只会置位TXDMAEN,不会产生传输;
+ *              DMA通道由本库通过HAL_DMA_Init配置,不要在CubeMX中再分配
+ * @warning	    接收缓冲区不能位于CCMRAM(DMA无法访问)
+ * @par 		历史版本
+                V1.0.0创建于26-10-17
+                V1.1.0创建于26-10-17, 装填后未触发时wait()返回false并计数,不再把上一次的数据当作新读数
+ * */
+
+#pragma once
+
+#include <cstdint>
+#include "main.h"
+
+template <uint8_t N>
+class SPI_TriggeredRead {
+public:
+    uint8_t buffer[N]{}; // 接收缓冲区
+
+    /**
+     * @param hspi SPI句柄,需已初始化
+     * @param rx_channel SPI接收DMA通道
+     * @param tx_channel SPI发送DMA通道
+     */
+    void init(SPI_HandleTypeDef *hspi, DMA_Channel_TypeDef *rx_channel, DMA_Channel_TypeDef *tx_channel) {
+        this->spi = hspi->Instance;
+        const bool spi1 = spi == SPI1, spi2 = spi == SPI2;
+        config(hdma_rx, rx_channel, spi1 ? DMA_REQUEST_SPI1_RX : spi2 ? DMA_REQUEST_SPI2_RX : DMA_REQUEST_SPI3_RX,
+               DMA_PERIPH_TO_MEMORY, DMA_MINC_ENABLE, DMA_PDATAALIGN_BYTE, DMA_MDATAALIGN_BYTE, DMA_NORMAL);
+        config(hdma_tx, tx_channel, spi1 ? DMA_REQUEST_SPI1_TX : spi2 ? DMA_REQUEST_SPI2_TX : DMA_REQUEST_SPI3_TX,
+               DMA_MEMORY_TO_PERIPH, DMA_MINC_DISABLE, DMA_PDATAALIGN_BYTE, DMA_MDATAALIGN_BYTE, DMA_NORMAL);
+        rx_channel->CPAR = reinterpret_cast<uint32_t>(&spi->DR);
+        rx_channel->CMAR = reinterpret_cast<uint32_t>(buffer);
+        tx_channel->CPAR = reinterpret_cast<uint32_t>(&spi->DR);
+        tx_channel->CMAR = reinterpret_cast<uint32_t>(&dummy);
+    }
+
+    /**
+     * @brief 绑定触发源,此后每个触发请求都会向SPI CR2写入TXDMAEN|RXDMAEN
+     * @param channel 触发DMA通道
+     * @param request 触发DMA请求,如DMA_REQUEST_TIM1_CH4
+     */
+    void attach_trigger(DMA_Channel_TypeDef *channel, const uint32_t request) {
+        config(hdma_trigger, channel, request, DMA_MEMORY_TO_PERIPH, DMA_MINC_DISABLE,
+               DMA_PDATAALIGN_HALFWORD, DMA_MDATAALIGN_HALFWORD, DMA_CIRCULAR);
+        trigger_word = static_cast<uint16_t>(spi->CR2 | SPI_CR2_RXDMAEN | SPI_CR2_TXDMAEN);
+        channel->CPAR = reinterpret_cast<uint32_t>(&spi->CR2);
+        channel->CMAR = reinterpret_cast<uint32_t>(&trigger_word);
+        channel->CNDTR = 1;
+        channel->CCR |= DMA_CCR_EN;
+    }
+
+    [[nodiscard]] bool triggered() const { return hdma_trigger.Instance != nullptr; }
+
+    [[nodiscard]] bool armed() const { return is_armed; }
+
+    /**
+     * @brief 装填下一次传输,由下一个触发请求启动
+     */
+    void arm() {
+        DMA_Channel_TypeDef *rx = hdma_rx.Instance, *tx = hdma_tx.Instance;
+        rx->CCR &= ~DMA_CCR_EN;
+        tx->CCR &= ~DMA_CCR_EN;
+        spi->CR2 = trigger_word & ~SPI_CR2_TXDMAEN;
+        rx->CNDTR = N;
+        tx->CNDTR = N;
+        rx->CCR |= DMA_CCR_EN;
+        tx->CCR |= DMA_CCR_EN;
+        is_armed = true;
+    }
+
+    /**
+     * @brief 停止DMA传输,之后可以使用阻塞方式读写SPI
+     */
+    void disarm() {
+        is_armed = false;
+        if (hdma_rx.Instance == nullptr) return;
+        hdma_rx.Instance->CCR &= ~DMA_CCR_EN;
+        hdma_tx.Instance->CCR &= ~DMA_CCR_EN;
+        spi->CR2 = trigger_word & ~(SPI_CR2_TXDMAEN | SPI_CR2_RXDMAEN);
+    }
+
+    /**
+     * @brief 等待正在进行的传输完成
+     * @return true: buffer为本次触发的完整数据; false: 装填后未触发或传输超时,已停止DMA,调用者需阻塞读取
+     * @note 未触发说明触发源停止(如TIM1停止或CCR4/DMA请求配置错误),buffer仍为上一次的数据,不能作为新读数
+     */
+    bool wait() {
+        if (hdma_tx.Instance->CNDTR == N) {
+            ++missed_count;
+            disarm();
+            return false;
+        }
+        for (uint32_t spin = 0; hdma_rx.Instance->CNDTR != 0; ++spin) {
+            if (spin > TIMEOUT_SPINS) {
+                ++timeout_count;
+                disarm();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    [[nodiscard]] uint32_t missed() const { return missed_count; }     // 装填后未触发的次数
+    [[nodiscard]] uint32_t timeouts() const { return timeout_count; }  // 传输超时的次数
+
+private:
+    static constexpr uint32_t TIMEOUT_SPINS = 2000; // 约为SPI_BAUDRATEPRESCALER_16下4字节传输时间的10倍
+
+    static void config(DMA_HandleTypeDef& hdma, DMA_Channel_TypeDef *channel, const uint32_t request,
+                       const uint32_t direction, const uint32_t mem_inc, const uint32_t periph_align,
+                       const uint32_t mem_align, const uint32_t mode) {
+        hdma.Instance = channel;
+        hdma.Init.Request = request;
+        hdma.Init.Direction = direction;
+        hdma.Init.PeriphInc = DMA_PINC_DISABLE;
+        hdma.Init.MemInc = mem_inc;
+        hdma.Init.PeriphDataAlignment = periph_align;
+        hdma.Init.MemDataAlignment = mem_align;
+        hdma.Init.Mode = mode;
+        hdma.Init.Priority = DMA_PRIORITY_VERY_HIGH;
+        if (HAL_DMA_Init(&hdma) != HAL_OK) Error_Handler();
+    }
+
+    SPI_TypeDef *spi = nullptr;
+    DMA_HandleTypeDef hdma_rx{}, hdma_tx{}, hdma_trigger{};
+    uint16_t trigger_word = 0;     // 触发时写入CR2的值
+    const uint8_t dummy = 0x00;    // 发送的填充数据
+    volatile bool is_armed = false;
+    uint32_t missed_count = 0;
+    uint32_t timeout_count = 0;
+};
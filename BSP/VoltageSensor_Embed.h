@@ -0,0 +1,83 @@
+/**
+ * @brief 		VoltageSensor_Embed.h库文件
+ * @detail      母线电压采样: ADC规则组由PWM定时器触发,DMA循环写入缓冲区,电流环中直接读取
+ * @author 	    Haoqi Liu
+ * @date        26-10-17
+ * @version 	V1.0.1
+ * @note 		规则组与电流采样使用同一触发(TIM1 TRGO2),注入组优先,规则转换紧随其后,每个PWM周期一次;
+ *              缓冲区保存最近BUFFER_SIZE个周期的结果,voltage()取平均,电流环读到的电压最多滞后BUFFER_SIZE个周期;
+ *              整个过程不占用CPU,也不产生中断
+ * @warning	    双ADC规则同步模式下由主ADC触发,从ADC的规则通道随之转换(不使用其结果);
+ *              DMA通道由本库通过HAL_DMA_Init配置,不要在CubeMX中再分配;缓冲区不能位于CCMRAM;
+ *              开始后不再停止: 电机停止时仍需母线电压做欠压/过压检测和掉电保存位置
+ * @par 		历史版本
+                V1.0.0创建于26-10-17
+                V1.0.1创建于26-10-17, 删除没有调用者的stop()
+ * */
+
+#pragma once
+
+#include <cstdint>
+#include "main.h"
+#include "adc.h"
+
+class VoltageSensor_Embed {
+public:
+    static constexpr uint8_t BUFFER_SIZE = 4; // 平均的PWM周期数
+
+    /**
+     * @param hadc 规则组采样母线电压的ADC,需已初始化
+     * @param scale ADC读数到母线电压的系数,单位V/LSB
+     */
+    VoltageSensor_Embed(ADC_HandleTypeDef *hadc, const float scale) : hadc(hadc), scale(scale / BUFFER_SIZE) {}
+
+    /**
+     * @brief 开始触发采样,需在ADC使能之后调用
+     * @param channel DMA通道
+     * @param trigger 规则组触发源,如LL_ADC_REG_TRIG_EXT_TIM1_TRGO2
+     */
+    void start(DMA_Channel_TypeDef *channel, const uint32_t trigger) {
+        ADC_TypeDef *adc = hadc->Instance;
+        LL_ADC_REG_StopConversion(adc);
+        while (LL_ADC_REG_IsStopConversionOngoing(adc)) {}
+
+        hdma.Instance = channel;
+        hdma.Init.Request = adc == ADC1 ? DMA_REQUEST_ADC1 : DMA_REQUEST_ADC2;
+        hdma.Init.Direction = DMA_PERIPH_TO_MEMORY;
+        hdma.Init.PeriphInc = DMA_PINC_DISABLE;
+        hdma.Init.MemInc = DMA_MINC_ENABLE;
+        hdma.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+        hdma.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+        hdma.Init.Mode = DMA_CIRCULAR;
+        hdma.Init.Priority = DMA_PRIORITY_HIGH;
+        if (HAL_DMA_Init(&hdma) != HAL_OK) Error_Handler();
+        channel->CPAR = reinterpret_cast<uint32_t>(&adc->DR);
+        channel->CMAR = reinterpret_cast<uint32_t>(buffer);
+        channel->CNDTR = BUFFER_SIZE;
+        channel->CCR |= DMA_CCR_EN;
+
+        LL_ADC_REG_SetTriggerSource(adc, trigger);
+        LL_ADC_REG_SetTriggerEdge(adc, LL_ADC_REG_TRIG_EXT_RISING);
+        LL_ADC_REG_SetDMATransfer(adc, LL_ADC_REG_DMA_TRANSFER_UNLIMITED);
+        LL_ADC_REG_StartConversion(adc); // 外部触发时只是开始等待触发
+        started = true;
+    }
+
+    [[nodiscard]] bool is_started() const { return started; }
+
+    /**
+     * @brief 最近BUFFER_SIZE个周期的平均母线电压,单位V
+     */
+    [[nodiscard]] float voltage() const {
+        uint32_t sum = 0;
+        for (const uint16_t value: buffer) sum += value;
+        return static_cast<float>(sum) * scale;
+    }
+
+private:
+    ADC_HandleTypeDef *hadc;
+    const float scale; // 含平均的系数,单位V/LSB
+    DMA_HandleTypeDef hdma{};
+    volatile uint16_t buffer[BUFFER_SIZE]{};
+    bool started{false};
+};
@@ -2,35 +2,29 @@
  * @brief 		CharCircularQueue库文件
  * @detail
  * @author 	    Haoqi Liu
- * @date        2025/6/22
- * @version 	V1.0.0
+ * @date        2026/10/17
+ * @version 	V2.0.0
  * @note 		
  * @warning	    
  * @par 		历史版本
                 V1.0.0创建于2025/6/22
+                V2.0.0创建于2026/10/17, 容量改为模板参数,缓冲区静态分配,不再使用堆
  * */
 
 #pragma once
 
+template <int Capacity>
 class CharCircularQueue {
-public:
-    // 构造函数：动态指定容量
-    explicit CharCircularQueue(const int capacity) :
-        size(capacity), head(0), tail(0), count(0) {
-        buf = new char[size];
-    }
-
-    ~CharCircularQueue() {
-        delete[] buf;
-    }
+    static_assert(Capacity > 0, "CharCircularQueue capacity must be positive");
 
+public:
     [[nodiscard]] bool isEmpty() const { return count == 0; }
-    [[nodiscard]] bool isFull() const { return count == size; }
+    [[nodiscard]] bool isFull() const { return count == Capacity; }
 
     bool enqueue(char c) {
         if (isFull()) return false;
         buf[tail] = c;
-        tail = (tail + 1) % size;
+        tail = (tail + 1) % Capacity;
         ++count;
         return true;
     }
@@ -38,19 +32,18 @@ public:
     bool dequeue(char& c) {
         if (isEmpty()) return false;
         c = buf[head];
-        head = (head + 1) % size;
+        head = (head + 1) % Capacity;
         --count;
         return true;
     }
 
     [[nodiscard]] char front() const { return buf[head]; }
-    [[nodiscard]] int Size() const { return size; }
+    [[nodiscard]] int Size() const { return Capacity; }
     [[nodiscard]] int currentSize() const { return count; }
 
 private:
-    char *buf;
-    int size;
-    int head;
-    int tail;
-    int count;
+    char buf[Capacity]{};
+    int head{0};
+    int tail{0};
+    int count{0};
 };
@@ -25,7 +25,7 @@ void RetargetInit() {
 #endif
 }
 
-CharCircularQueue rx_queue{128};
+CharCircularQueue<128> rx_queue;
 TxDualBuffer<char, 512> tx_buffer(&CDC_Transmit_FS);
 extern QD4310 qd4310;
 
@@ -3,8 +3,8 @@
  * @brief 		用于支持简单平台移植的中间层
  * @detail
  * @author 	    Haoqi Liu
- * @date        26-5-29
- * @version 	V3.3.0
+ * @date        26-10-17
+ * @version 	V3.4.1
  * @note 		用户需要根据提示定义相关宏函数,其中,MAX_DELAY应与delay()匹配
  * @warning
  * @par 		历史版本
@@ -14,6 +14,8 @@
                 V3.1.0创建于25-9-11, 添加另外两个重载delete函数
                 V3.2.0创建于26-3-29, 添加delay_us()函数
                 V3.3.0创建于26-5-29, 添加硬件版本识别
+                V3.4.0创建于26-10-17, 添加FreeRTOS任务运行时间统计时基
+                V3.4.1创建于26-10-17, 运行时间统计改为移位分频,关中断区只做溢出扩展
  * */
 
 #include <cmath>
@@ -42,3 +44,28 @@ void version_detect() {
         }
     }
 }
+
+static uint32_t runtime_last{0}; // 上次读取的DWT计数值
+static uint32_t runtime_high{0}; // DWT计数器溢出次数
+static uint8_t runtime_shift{0}; // 分频移位数,2^shift不超过SystemCoreClock / configRUN_TIME_STATS_FREQUENCY
+
+void sys_runtime_stats_init() {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    runtime_last = DWT->CYCCNT;
+    runtime_high = 0;
+    runtime_shift = 0;
+    while ((2u << runtime_shift) <= SystemCoreClock / configRUN_TIME_STATS_FREQUENCY) ++runtime_shift;
+}
+
+uint32_t sys_runtime_stats_counter() {
+    // 关中断只保护溢出扩展,分频在关中断区外以移位完成,不推迟电流环中断
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    const uint32_t now = DWT->CYCCNT;
+    if (now < runtime_last) ++runtime_high;
+    runtime_last = now;
+    const uint32_t high = runtime_high;
+    __set_PRIMASK(primask);
+    return runtime_shift ? high << (32 - runtime_shift) | now >> runtime_shift : now;
+}
@@ -3,8 +3,8 @@
  * @brief 		用于支持简单平台移植的中间层
  * @detail
  * @author 	    Haoqi Liu
- * @date        26-3-29
- * @version 	V3.2.0
+ * @date        26-10-17
+ * @version 	V3.5.1
  * @note 		用户需要根据提示定义相关宏函数,其中,MAX_DELAY应与delay()匹配
  * @warning
  * @par 		历史版本
@@ -13,6 +13,10 @@
                 V3.0.0创建于25-4-17, 重写new和delete函数
                 V3.1.0创建于25-9-11, 添加另外两个重载delete函数
                 V3.2.0创建于26-3-29, 添加delay_us()函数
+                V3.3.0创建于26-5-29, 添加硬件版本识别
+                V3.4.0创建于26-10-17, 添加FreeRTOS任务运行时间统计时基
+                V3.5.0创建于26-10-17, 零堆模式下new在链接时报错
+                V3.5.1创建于26-10-17, 运行时间统计改为移位分频,关中断区只做溢出扩展
  * */
 
 #ifndef SYS_PUBLIC_H
@@ -62,6 +66,15 @@ extern "C" {
 
 extern void version_detect();
 
+/**
+ * @brief FreeRTOS任务运行时间统计时基,由FreeRTOSConfig.h中的portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()等宏调用
+ * @note 使用DWT周期计数器,软件扩展溢出次数后右移分频,频率为不低于configRUN_TIME_STATS_FREQUENCY的
+ *       SystemCoreClock / 2^n(170MHz下约10.4kHz),只用于计算任务CPU占比,返回值按32位回绕
+ *       DWT计数器约25s溢出一次,任务切换时都会读取计数值,故可以可靠地检测溢出
+ */
+extern void sys_runtime_stats_init(void);
+extern uint32_t sys_runtime_stats_counter(void);
+
 #ifdef __cplusplus
 };
 
@@ -69,6 +82,34 @@ extern void version_detect();
 #include <cstdint>
 #include "FreeRTOS.h"
 /**=====================================User Code End=====================================**/
+#if defined(QDRIVE_STATIC_ALLOCATION) && QDRIVE_STATIC_ALLOCATION
+/**
+ * @brief 零堆模式下不存在堆,该函数故意不提供定义,
+ *        任何代码使用new都会在链接时报undefined reference,从而定位到仍在动态分配的地方
+ */
+extern "C" void qdrive_static_allocation_violation_operator_new_is_used();
+
+inline void* operator new(const std::size_t size) {
+    (void)size;
+    qdrive_static_allocation_violation_operator_new_is_used();
+    return nullptr;
+}
+
+inline void* operator new[](const std::size_t size) {
+    (void)size;
+    qdrive_static_allocation_violation_operator_new_is_used();
+    return nullptr;
+}
+
+// 虚析构函数会引用delete,故delete不能报错,零堆模式下没有可释放的内存
+inline void operator delete(void *ptr) { (void)ptr; }
+
+inline void operator delete(void *ptr, std::size_t) { (void)ptr; }
+
+inline void operator delete[](void *ptr) { (void)ptr; }
+
+inline void operator delete[](void *ptr, std::size_t) { (void)ptr; }
+#else
 inline void* operator new(const std::size_t size) {
     return pvPortMalloc(size);
 }
@@ -93,5 +134,6 @@ inline void operator delete[](void *ptr, std::size_t) {
     vPortFree(ptr);
 }
 #endif
+#endif
 
 #endif //SYS_PUBLIC_H
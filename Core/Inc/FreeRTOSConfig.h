@@ -169,6 +169,20 @@ standard names. */
 
 /* USER CODE BEGIN Defines */
 /* Section where parameter definitions can be added (for instance, to override default ones in FreeRTOS.h) */
+/* 任务运行时间统计,时基为DWT周期计数器右移分频至约10kHz(不低于configRUN_TIME_STATS_FREQUENCY),见sys_public.cpp */
+#define configGENERATE_RUN_TIME_STATS            1
+#define configRUN_TIME_STATS_FREQUENCY           10000U
+#if defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__)
+  void sys_runtime_stats_init(void);
+  uint32_t sys_runtime_stats_counter(void);
+#endif
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() sys_runtime_stats_init()
+#define portGET_RUN_TIME_COUNTER_VALUE()         sys_runtime_stats_counter()
+/* 零堆模式(CMake选项QDRIVE_STATIC_ALLOCATION): 所有内核对象均静态分配,heap_4.c不参与编译 */
+#if defined(QDRIVE_STATIC_ALLOCATION) && QDRIVE_STATIC_ALLOCATION
+  #undef configSUPPORT_DYNAMIC_ALLOCATION
+  #define configSUPPORT_DYNAMIC_ALLOCATION       0
+#endif
 /* USER CODE END Defines */
 
 #endif /* FREERTOS_CONFIG_H */
@@ -51,31 +51,51 @@
 /* USER CODE END Variables */
 /* Definitions for DebugTask */
 osThreadId_t DebugTaskHandle;
+uint32_t DebugTaskBuffer[ 64 ];
+osStaticThreadDef_t DebugTaskControlBlock;
 const osThreadAttr_t DebugTask_attributes = {
   .name = "DebugTask",
+  .cb_mem = &DebugTaskControlBlock,
+  .cb_size = sizeof(DebugTaskControlBlock),
+  .stack_mem = &DebugTaskBuffer[0],
+  .stack_size = sizeof(DebugTaskBuffer),
   .priority = (osPriority_t) osPriorityNormal,
-  .stack_size = 64 * 4
 };
 /* Definitions for FOCTask */
 osThreadId_t FOCTaskHandle;
+uint32_t FOCTaskBuffer[ 128 ];
+osStaticThreadDef_t FOCTaskControlBlock;
 const osThreadAttr_t FOCTask_attributes = {
   .name = "FOCTask",
+  .cb_mem = &FOCTaskControlBlock,
+  .cb_size = sizeof(FOCTaskControlBlock),
+  .stack_mem = &FOCTaskBuffer[0],
+  .stack_size = sizeof(FOCTaskBuffer),
   .priority = (osPriority_t) osPriorityRealtime,
-  .stack_size = 128 * 4
 };
 /* Definitions for CommunicateTask */
 osThreadId_t CommunicateTaskHandle;
+uint32_t CommunicateTaskBuffer[ 128 ];
+osStaticThreadDef_t CommunicateTaskControlBlock;
 const osThreadAttr_t CommunicateTask_attributes = {
   .name = "CommunicateTask",
+  .cb_mem = &CommunicateTaskControlBlock,
+  .cb_size = sizeof(CommunicateTaskControlBlock),
+  .stack_mem = &CommunicateTaskBuffer[0],
+  .stack_size = sizeof(CommunicateTaskBuffer),
   .priority = (osPriority_t) osPriorityAboveNormal,
-  .stack_size = 128 * 4
 };
 /* Definitions for StartShell */
 osThreadId_t StartShellHandle;
+uint32_t StartShellBuffer[ 128 ];
+osStaticThreadDef_t StartShellControlBlock;
 const osThreadAttr_t StartShell_attributes = {
   .name = "StartShell",
+  .cb_mem = &StartShellControlBlock,
+  .cb_size = sizeof(StartShellControlBlock),
+  .stack_mem = &StartShellBuffer[0],
+  .stack_size = sizeof(StartShellBuffer),
   .priority = (osPriority_t) osPriorityNormal,
-  .stack_size = 128 * 4
 };
 
 /* Private function prototypes -----------------------------------------------*/
@@ -0,0 +1,44 @@
+/**
+ * @brief 		BLDC_Driver_Sim.h库文件
+ * @detail      主机仿真用BLDC驱动,仅记录三相归一化占空比,供MotorPlant读取
+ * @author 	    Haoqi Liu
+ * @date        26-10-17
+ * @version 	V1.0.0
+ * @note 		与BLDC_Driver_DRV8300一致,未使能时忽略set_duty
+ * @warning	    
+ * @par 		历史版本
+                V1.0.0创建于26-10-17
+ * */
+
+#ifndef BLDC_DRIVER_SIM_H
+#define BLDC_DRIVER_SIM_H
+
+#include "BLDC_Driver.h"
+
+class BLDC_Driver_Sim final : public BLDC_Driver {
+public:
+    ~BLDC_Driver_Sim() override = default;
+
+    BLDC_Driver_Sim() { initialized = true; }
+
+    void init() override { initialized = true; }
+
+    void enable() override { enabled = true; }
+
+    void disable() override {
+        set_duty(0, 0, 0);
+        enabled = false;
+    }
+
+    void set_duty(const float u, const float v, const float w) override {
+        if (enabled) {
+            du = u;
+            dv = v;
+            dw = w;
+        }
+    }
+
+    float du{}, dv{}, dw{}; // 三相归一化占空比
+};
+
+#endif //BLDC_DRIVER_SIM_H
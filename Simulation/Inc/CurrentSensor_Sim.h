@@ -0,0 +1,108 @@
+/**
+ * @brief 		CurrentSensor_Sim.h库文件
+ * @detail      主机仿真用电流传感器,按CurrentSensor_Embed的12bit ADC量化MotorPlant的相电流
+ * @author 	    Haoqi Liu
+ * @date        26-10-17
+ * @version 	V1.2.0
+ * @note 		与CurrentSensor_Embed一致,iw由iu、iv重构,update()需在每次电流环前调用;
+ *              可叠加高斯ADC噪声,过采样时对N次独立噪声的12bit结果求和后折算,与硬件过采样一致;
+ *              占空比超过max_duty的一相下桥导通时间不足,采样电阻无电流,读数为0;
+ *              三电阻采样时与CurrentSensor_Embed相同,由select_phases()跳过占空比最大的一相
+ * @warning	    
+ * @par 		历史版本
+                V1.0.0创建于26-10-17
+                V1.1.0创建于26-10-17, 添加ADC噪声和过采样模型
+                V1.2.0创建于26-10-17, 添加下桥导通时间不足的采样失效模型和三电阻采样
+ * */
+
+#ifndef CURRENTSENSOR_SIM_H
+#define CURRENTSENSOR_SIM_H
+
+#include <cmath>
+#include <random>
+#include "CurrentSensor.h"
+#include "MotorPlant.h"
+#include "BLDC_Driver_Sim.h"
+
+class CurrentSensor_Sim final : public CurrentSensor {
+public:
+    float noise_lsb{0.0f};   // 单次转换的ADC噪声标准差,单位LSB
+    uint8_t oversampling{1}; // 过采样倍数
+    float max_duty{1.0f};    // 采样有效的最大占空比,超过时该相读数为0
+    bool three_shunt{false}; // 三电阻采样
+
+    CurrentSensor_Sim(const MotorPlant& plant, const BLDC_Driver_Sim& driver) : plant(plant), driver(driver) {}
+
+    void init() override { initialized = true; }
+
+    void enable() override { enabled = true; }
+
+    void disable() override { enabled = false; }
+
+    void set_offset(const float iu_offset, const float iv_offset, const float iw_offset) override {
+        this->iu_offset = iu_offset;
+        this->iv_offset = iv_offset;
+        this->iw_offset = iw_offset;
+    }
+
+    /**
+     * @brief 按新占空比选择下一次采样的两相,与CurrentSensor_Embed::select_phases()相同
+     */
+    void select_phases(const float du, const float dv, const float dw) {
+        if (!three_shunt) return;
+        skip_u = du >= dv && du >= dw;
+        skip_v = !skip_u && dv >= dw;
+    }
+
+    void update() {
+        float iu, iv, iw;
+        plant.phase_currents(iu, iv, iw);
+        if (skip_u) {
+            this->iv = sample(iv, driver.dv, iv_offset);
+            this->iw = sample(iw, driver.dw, iw_offset);
+            this->iu = -(this->iv + this->iw);
+        } else if (skip_v) {
+            this->iu = sample(iu, driver.du, iu_offset);
+            this->iw = sample(iw, driver.dw, iw_offset);
+            this->iv = -(this->iu + this->iw);
+        } else {
+            this->iu = sample(iu, driver.du, iu_offset);
+            this->iv = sample(iv, driver.dv, iv_offset);
+            this->iw = (three_shunt ? 0.0f : iw_offset) - (this->iu + this->iv);
+        }
+    }
+
+private:
+    static constexpr float LSB = 3.3f / (4096 - 1) / 20.0f / 0.05f; // 与CurrentSensor_Embed相同的量化步长,单位A
+
+    float iu_offset{}, iv_offset{}, iw_offset{}; // 电流偏置,单位A
+    bool skip_u{false}, skip_v{false};           // 三电阻采样时跳过的相,都为false时采样U、V
+    std::mt19937 rng{1};
+    std::normal_distribution<float> noise{0.0f, 1.0f};
+
+    /**
+     * @brief 采样一相电流
+     * @param current 真实相电流,单位A
+     * @param duty 该相占空比
+     * @param offset 电流偏置,单位A
+     */
+    float sample(const float current, const float duty, const float offset) {
+        return offset + convert(duty > max_duty ? 0.0f : current / LSB) * LSB;
+    }
+
+    /**
+     * @brief 模拟一次(过采样)转换
+     * @param lsb 理想的ADC读数,单位LSB
+     * @return 折算回单次转换的读数,单位LSB
+     */
+    float convert(const float lsb) {
+        float sum = 0;
+        for (uint8_t i = 0; i < oversampling; ++i) sum += std::round(lsb + noise_lsb * noise(rng));
+        return sum / static_cast<float>(oversampling);
+    }
+
+    const MotorPlant& plant;
+    const BLDC_Driver_Sim& driver;
+};
+
+#endif //CURRENTSENSOR_SIM_H
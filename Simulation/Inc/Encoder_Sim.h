@@ -0,0 +1,48 @@
+/**
+ * @brief 		Encoder_Sim.h库文件
+ * @detail      主机仿真用编码器,按MT6826S的15bit分辨率量化MotorPlant的机械角度
+ * @author 	    Haoqi Liu
+ * @date        26-10-17
+ * @version 	V1.0.0
+ * @note 		
+ * @warning	    
+ * @par 		历史版本
+                V1.0.0创建于26-10-17
+ * */
+
+#ifndef ENCODER_SIM_H
+#define ENCODER_SIM_H
+
+#include <cmath>
+#include <numbers>
+#include "Encoder.h"
+#include "MotorPlant.h"
+
+class Encoder_Sim final : public Encoder {
+public:
+    ~Encoder_Sim() override = default;
+
+    explicit Encoder_Sim(const MotorPlant& plant) : plant(plant) {}
+
+    void init() override {
+        resolution = 2 * std::numbers::pi_v<float> / 32768.0f;
+        initialized = true;
+    }
+
+    void enable() override {
+        if (!initialized) return;
+        enabled = true;
+    }
+
+    void disable() override { enabled = false; }
+
+    float get_angle() override {
+        if (!enabled) return 0;
+        return std::floor(plant.mechanical_angle() / resolution) * resolution;
+    }
+
+private:
+    const MotorPlant& plant;
+};
+
+#endif //ENCODER_SIM_H
@@ -0,0 +1,105 @@
+/**
+ * @brief 		MotorPlant.h库文件
+ * @detail      表贴式PMSM离散时间模型(dq坐标系),电机参数取自QDrive_cfg.h中的FOC_*常量
+ * @author 	    Haoqi Liu
+ * @date        26-10-17
+ * @version 	V1.1.0
+ * @note 		输入为三相归一化占空比和母线电压,逆变器视为理想开关(无导通压降),
+ *              可选死区: 每相平均电压损失 sign(i)·dead_time·V_bus,电流符号取每个PWM周期开始时的值;
+ *              每个PWM周期内以固定子步长做显式欧拉积分
+ * @warning	    转动惯量和阻尼系数未在QDrive_cfg.h中给出,为4310电机的估计值
+ * @par 		历史版本
+                V1.0.0创建于26-10-17
+                V1.1.0创建于26-10-17, 添加死区模型
+ * */
+
+#ifndef MOTOR_PLANT_H
+#define MOTOR_PLANT_H
+
+#include <cmath>
+#include <cstdint>
+#include <numbers>
+#include "QDrive_cfg.h"
+
+class MotorPlant {
+public:
+    static constexpr float PHASE_RESISTANCE = FOC_PHASE_RESISTANCE;          // 相电阻,单位Ω
+    static constexpr float PHASE_INDUCTANCE = FOC_PHASE_INDUCTANCE * 1e-3f;  // 相电感,单位H
+    static constexpr float FLUX_LINKAGE = FOC_TORQUE_CONSTANT /               // 永磁磁链,单位Wb
+                                          (1.5f * FOC_POLE_PAIRS);            // Kt = 3/2 * p * ψf
+    static constexpr float INERTIA = 5e-5f;                                   // 转动惯量,单位kg·m²
+    static constexpr float DAMPING = 2e-5f;                                   // 粘滞阻尼,单位N·m·s/rad
+
+    float bus_voltage{FOC_NOMINAL_VOLTAGE}; // 母线电压,单位V
+    float load_torque{0.0f};                // 负载转矩,单位N·m
+    float dead_time{0.0f};                  // 死区时间占PWM周期的比例,0为理想逆变器
+
+    /**
+     * @brief 推进仿真
+     * @param du,dv,dw 三相归一化占空比,范围[0,1]
+     * @param driving 逆变器是否输出,为false时三相悬空,电流为零
+     * @param dt 推进时长,单位s
+     * @param substeps 积分子步数
+     */
+    void step(float du, float dv, float dw, const bool driving, const float dt, const uint16_t substeps = 10) {
+        du = std::fmin(std::fmax(du, 0.0f), 1.0f);
+        dv = std::fmin(std::fmax(dv, 0.0f), 1.0f);
+        dw = std::fmin(std::fmax(dw, 0.0f), 1.0f);
+        if (dead_time > 0.0f) {
+            float iu, iv, iw;
+            phase_currents(iu, iv, iw);
+            const auto sign = [](const float i) { return static_cast<float>((i > 0.0f) - (i < 0.0f)); };
+            du -= dead_time * sign(iu);
+            dv -= dead_time * sign(iv);
+            dw -= dead_time * sign(iw);
+        }
+        // Clarke变换(等幅值),共模电压不影响相电流
+        const float u_alpha = bus_voltage * (2.0f * du - dv - dw) / 3.0f;
+        const float u_beta = bus_voltage * (dv - dw) / std::numbers::sqrt3_v<float>;
+
+        const float h = dt / static_cast<float>(substeps);
+        for (uint16_t i = 0; i < substeps; ++i) {
+            const float we = FOC_POLE_PAIRS * omega; // 电角速度
+            if (driving) {
+                const float c = std::cos(electric_angle()), s = std::sin(electric_angle());
+                const float ud = c * u_alpha + s * u_beta;
+                const float uq = -s * u_alpha + c * u_beta;
+                const float did = (ud - PHASE_RESISTANCE * id + we * PHASE_INDUCTANCE * iq) / PHASE_INDUCTANCE;
+                const float diq = (uq - PHASE_RESISTANCE * iq - we * PHASE_INDUCTANCE * id - we * FLUX_LINKAGE) /
+                                  PHASE_INDUCTANCE;
+                id += did * h;
+                iq += diq * h;
+            } else {
+                id = iq = 0.0f;
+            }
+            const float torque = 1.5f * FOC_POLE_PAIRS * FLUX_LINKAGE * iq;
+            omega += (torque - DAMPING * omega - load_torque) / INERTIA * h;
+            theta = std::fmod(theta + omega * h, 2 * std::numbers::pi_v<float>);
+            if (theta < 0) theta += 2 * std::numbers::pi_v<float>;
+        }
+    }
+
+    [[nodiscard]] float mechanical_angle() const { return theta; }                      // 机械角度,单位rad
+    [[nodiscard]] float electric_angle() const { return FOC_POLE_PAIRS * theta; }       // 电角度,单位rad
+    [[nodiscard]] float speed_rpm() const { return omega * 60.0f / (2 * std::numbers::pi_v<float>); }
+    [[nodiscard]] float current_d() const { return id; }
+    [[nodiscard]] float current_q() const { return iq; }
+    [[nodiscard]] float torque() const { return 1.5f * FOC_POLE_PAIRS * FLUX_LINKAGE * iq; }
+
+    // 三相电流,单位A
+    void phase_currents(float& iu, float& iv, float& iw) const {
+        const float c = std::cos(electric_angle()), s = std::sin(electric_angle());
+        const float i_alpha = c * id - s * iq;
+        const float i_beta = s * id + c * iq;
+        iu = i_alpha;
+        iv = -0.5f * i_alpha + std::numbers::sqrt3_v<float> / 2 * i_beta;
+        iw = -0.5f * i_alpha - std::numbers::sqrt3_v<float> / 2 * i_beta;
+    }
+
+private:
+    float id{0.0f}, iq{0.0f}; // dq轴电流,单位A
+    float omega{0.0f};        // 机械角速度,单位rad/s
+    float theta{0.0f};        // 机械角度,单位rad
+};
+
+#endif //MOTOR_PLANT_H
@@ -0,0 +1,60 @@
+/**
+ * @brief 		Storage_Sim.h库文件
+ * @detail      主机仿真用存储器,以RAM数组模拟Storage_EmbeddedFlash
+ * @author 	    Haoqi Liu
+ * @date        26-10-17
+ * @version 	V1.0.0
+ * @note 		构造时预置一份基础校准数据(编码器正向、电角度零点为0、无电流偏置),
+ *              使仿真启动后无需执行校准即可进入闭环
+ * @warning	    
+ * @par 		历史版本
+                V1.0.0创建于26-10-17
+ * */
+
+#ifndef STORAGE_SIM_H
+#define STORAGE_SIM_H
+
+#include <algorithm>
+#include <cstring>
+#include "Storage.h"
+#include "QDrive_cfg.h"
+
+class Storage_Sim final : public Storage {
+public:
+    static constexpr uint32_t SIZE = 0x2800; // 与固件中的存储器大小一致
+
+    Storage_Sim() : Storage(SIZE) {
+        std::fill_n(memory, SIZE, 0xFF); // 与擦除后的flash一致
+        constexpr uint8_t magic = 0xAA;
+        constexpr uint8_t status = 0b0000'0001; // STORAGE_BASE_CALIBRATE_OK
+        constexpr int8_t encoder_direction = 1;
+        constexpr float zero_electric_angle = 0.0f, offset = 0.0f;
+        constexpr float phase_resistance = FOC_PHASE_RESISTANCE, phase_inductance = FOC_PHASE_INDUCTANCE;
+        std::memcpy(&memory[0x000], &magic, sizeof(magic));
+        std::memcpy(&memory[0x010], &status, sizeof(status));
+        std::fill_n(&memory[0x100], 0x060, 0); // 与freeze_storage一致,基础校准块先清零
+        std::memcpy(&memory[0x100], &encoder_direction, sizeof(encoder_direction)); // 小端,兼容更宽的整型
+        std::memcpy(&memory[0x110], &zero_electric_angle, sizeof(zero_electric_angle));
+        std::memcpy(&memory[0x120], &offset, sizeof(offset));
+        std::memcpy(&memory[0x130], &offset, sizeof(offset));
+        std::memcpy(&memory[0x140], &phase_resistance, sizeof(phase_resistance));
+        std::memcpy(&memory[0x150], &phase_inductance, sizeof(phase_inductance));
+    }
+
+    void init() override { initialized = true; }
+
+    void write(const uint32_t addr, void *buff, const uint32_t count) override {
+        if (addr + count > SIZE) return;
+        std::memcpy(&memory[addr], buff, count);
+    }
+
+    void read(const uint32_t addr, void *buff, const uint32_t count) override {
+        if (addr + count > SIZE) return;
+        std::memcpy(buff, &memory[addr], count);
+    }
+
+private:
+    uint8_t memory[SIZE]{};
+};
+
+#endif //STORAGE_SIM_H
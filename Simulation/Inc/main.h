@@ -0,0 +1,68 @@
+/**
+ * @brief 		主机仿真用main.h
+ * @detail      替代Core/Inc/main.h,仅提供UserLib在主机上编译所需的最小HAL接口
+ * @author 	    Haoqi Liu
+ * @date        26-10-17
+ * @version 	V1.1.0
+ * @note 		HAL函数均为空实现,见Simulation/Src/hal_stub.cpp
+ * @warning	    仅用于主机仿真,请勿在固件中包含此文件
+ * @par 		历史版本
+                V1.0.0创建于26-10-17
+                V1.1.0创建于26-10-17, 添加PRIMASK读写,仿真单线程运行,均为空操作
+ * */
+
+#ifndef __MAIN_H
+#define __MAIN_H
+
+#include <cstdint>
+#include <cstddef>
+
+typedef enum {
+    HAL_OK = 0x00U,
+    HAL_ERROR = 0x01U,
+    HAL_BUSY = 0x02U,
+    HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+typedef enum {
+    GPIO_PIN_RESET = 0U,
+    GPIO_PIN_SET
+} GPIO_PinState;
+
+typedef struct {
+    uint32_t ODR; // 输出数据寄存器,仅用于观察LED状态
+} GPIO_TypeDef;
+
+typedef struct {
+    uint32_t BaudRate;
+} UART_InitTypeDef;
+
+typedef struct {
+    UART_InitTypeDef Init;
+} UART_HandleTypeDef;
+
+extern GPIO_TypeDef sim_gpiob;
+#define GPIOB                       (&sim_gpiob)
+#define GPIO_PIN_6                  ((uint16_t)0x0040)
+#define GPIO_PIN_7                  ((uint16_t)0x0080)
+
+#define LED_R_Pin                   GPIO_PIN_6
+#define LED_R_GPIO_Port             GPIOB
+#define LED_G_Pin                   GPIO_PIN_7
+#define LED_G_GPIO_Port             GPIOB
+
+#define assert_param(expr)          ((void)0U)
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_UART_DeInit(UART_HandleTypeDef *huart);
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart);
+void Error_Handler();
+
+// 仿真中控制回调与命令在同一线程中依次执行,临界区无需屏蔽中断
+inline uint32_t __get_PRIMASK() { return 0; }
+inline void __set_PRIMASK(uint32_t) {}
+inline void __disable_irq() {}
+
+#endif //__MAIN_H
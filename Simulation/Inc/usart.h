@@ -0,0 +1,18 @@
+/**
+ * @brief 		主机仿真用usart.h
+ * @detail      替代Core/Inc/usart.h
+ * @author 	    Haoqi Liu
+ * @date        26-10-17
+ * @version 	V1.0.0
+ * @par 		历史版本
+                V1.0.0创建于26-10-17
+ * */
+
+#ifndef __USART_H__
+#define __USART_H__
+
+#include "main.h"
+
+extern UART_HandleTypeDef huart3;
+
+#endif //__USART_H__
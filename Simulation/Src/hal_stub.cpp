@@ -0,0 +1,49 @@
+/**
+ * @file        hal_stub.cpp
+ * @brief       主机仿真用HAL空实现
+ * @details
+ * @author      Liu-Curiousity (2675794963@qq.com)
+ * @date        2026-10-17
+ * @version     V1.0.0
+ * @note
+ * @warning
+ * @par         历史版本:
+ *		        V1.0.0创建于2026-10-17
+ * @copyright   (c) 2026 QDrive
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include "main.h"
+#include "usart.h"
+
+GPIO_TypeDef sim_gpiob{};
+UART_HandleTypeDef huart3{};
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, const uint16_t GPIO_Pin, const GPIO_PinState PinState) {
+    if (PinState == GPIO_PIN_SET) GPIOx->ODR |= GPIO_Pin;
+    else GPIOx->ODR &= ~GPIO_Pin;
+}
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, const uint16_t GPIO_Pin) {
+    GPIOx->ODR ^= GPIO_Pin;
+}
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart) {
+    (void)huart;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_DeInit(UART_HandleTypeDef *huart) {
+    (void)huart;
+    return HAL_OK;
+}
+
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart) {
+    (void)huart;
+}
+
+void Error_Handler() {
+    std::fprintf(stderr, "Error_Handler called\n");
+    std::abort();
+}
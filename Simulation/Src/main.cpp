@@ -0,0 +1,903 @@
+/**
+ * @file        main.cpp
+ * @brief       QD4310主机仿真入口
+ * @details     以MotorPlant代替真实电机,使用与FOCTask相同的QD4310配置在主机上闭环运行,
+ *              用于控制算法的快速验证和性能测量
+ * @author      Liu-Curiousity (2675794963@qq.com)
+ * @date        2026-10-17
+ * @version     V1.14.2
+ * @note        调度方式与固件一致: 电流环20kHz(ADC注入中断,FOC_CURRENT_DOUBLE_RATE时40kHz),速度环位置环5kHz(TIM6中断),
+ *              电压采样与错误检测1kHz(FOCTask)
+ * @warning
+ * @par         历史版本:
+ *		        V1.0.0创建于2026-10-17
+ *		        V1.1.0创建于2026-10-17, 添加CRC8逐位计算与查表法的耗时对比
+ *		        V1.1.1创建于2026-10-17, CRC8一致性检查加入Crc8Engine(主机上为软件后端)
+ *		        V1.2.0创建于2026-10-17, 编码器经Encoder_Compensated延迟补偿,添加转矩脉动随转速变化的对比
+ *		        V1.3.0创建于2026-10-17, 速度滤波器随配置选择PLL观测器,添加PLL与差分低通的滞后和噪声对比
+ *		        V1.4.0创建于2026-10-17, 添加多圈角度控制场景
+ *		        V1.5.0创建于2026-10-17, 添加ADC过采样对电流测量噪声和转矩脉动影响的对比
+ *		        V1.6.0创建于2026-10-17, 添加Q15定点坐标变换与浮点实现的误差和耗时对比
+ *		        V1.7.0创建于2026-10-17, 添加高调制深度下两电阻与三电阻采样的对比
+ *		        V1.8.0创建于2026-10-17, 与固件一致,FOC_VBUS_DMA开启时每个电流环周期更新母线电压
+ *		        V1.9.0创建于2026-10-17, 占空比经BLDC_Modulator按母线电压归一化,添加不同母线电压下电流阶跃响应的对比
+ *		        V1.10.0创建于2026-10-17, 添加SVPWM与SPWM在不同调制深度下的线电压误差对比
+ *		        V1.11.0创建于2026-10-17, 与固件一致接入弱磁控制,添加低母线电压下弱磁与过调制的最高转速对比
+ *		        V1.12.0创建于2026-10-17, 与固件一致接入死区补偿,添加死区校准与补偿前后低速转矩脉动的对比
+ *		        V1.13.0创建于2026-10-17, 电流环频率与滤波器、PID周期随FOC_CURRENT_LOOP_FREQUENCY配置
+ *		        V1.13.1创建于2026-10-17, fixed场景的误差限与FixedPointFOC声明的5LSB上限一致
+ *		        V1.13.2创建于2026-10-17, 与固件一致,母线电压归一化由FOC_VBUS_COMPENSATION决定初值
+ *		        V1.13.3创建于2026-10-17, 与固件一致,弱磁电流从Q轴电流限幅中扣除
+ *		        V1.14.0创建于2026-10-17, 场景的状态恢复和统计提取为Restore、Statistic、sample()等公共工具
+ *		        V1.14.1创建于2026-10-17, 去掉主机上Crc8Engine(即查表法)与自身的比较,硬件CRC改由目标板perf crc检查
+ *		        V1.14.2创建于2026-10-17, 与固件一致,死区校准由QD4310::injectCurrentD()注入D轴电流
+ * @copyright   (c) 2026 QDrive
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <numbers>
+#include <vector>
+#include "main.h"
+#include "QDrive_cfg.h"
+#include "QD4310.h"
+#include "filters.h"
+#include "MotorPlant.h"
+#include "BLDC_Driver_Sim.h"
+#include "Encoder_Sim.h"
+#include "CurrentSensor_Sim.h"
+#include "Storage_Sim.h"
+#include "CRC8.h"
+#include "Encoder_Compensated.h"
+#include "BLDC_Modulator.h"
+#include "FieldWeakening.h"
+#include "PLL_SpeedObserver.h"
+#include "FixedPointFOC.h"
+
+using namespace std;
+
+constexpr float CURRENT_LOOP_PERIOD = 1.0f / FOC_CURRENT_LOOP_FREQUENCY; // 电流环周期,单位s
+
+MotorPlant plant;
+BLDC_Driver_Sim bldc_driver;
+BLDC_Modulator modulator(bldc_driver, FOC_NOMINAL_VOLTAGE, FOC_ABSOLUTE_MIN_VOLTAGE, FOC_ABSOLUTE_MAX_VOLTAGE,
+                         CURRENT_LOOP_PERIOD);
+FieldWeakening field_weakening(CURRENT_LOOP_PERIOD, FOC_FW_GAIN, FOC_FW_MAX_CURRENT, FOC_FW_THRESHOLD,
+                               FOC_MAX_CURRENT);
+Encoder_Sim bldc_encoder(plant);
+// 仿真中角度在周期末采样,新占空比作用于下一整个周期,采样到生效窗口中点的延迟为半个周期
+Encoder_Compensated compensated_encoder(bldc_encoder, 0.5f * CURRENT_LOOP_PERIOD);
+CurrentSensor_Sim current_sensor(plant, bldc_driver);
+Storage_Sim storage;
+
+LowPassFilter_2_Order CurrentQFilter(CURRENT_LOOP_PERIOD, 1500);
+LowPassFilter_2_Order CurrentDFilter(CURRENT_LOOP_PERIOD, 1500);
+#if FOC_SPEED_OBSERVER_PLL
+PLL_SpeedObserver SpeedFilter(CURRENT_LOOP_PERIOD, FOC_SPEED_PLL_BANDWIDTH);
+#else
+LowPassFilter_2_Order SpeedFilter(CURRENT_LOOP_PERIOD, 300);
+#endif
+
+QD4310 qd4310(FOC_POLE_PAIRS, 5000, FOC_CURRENT_LOOP_FREQUENCY,
+              CurrentQFilter, CurrentDFilter, SpeedFilter,
+              modulator, compensated_encoder, storage, current_sensor,
+              PID(PID::delta_type,
+                  FOC_CURRENT_KP,
+                  FOC_CURRENT_KI,
+                  FOC_CURRENT_KD,
+                  CURRENT_LOOP_PERIOD,
+                  nullopt,
+                  nullopt,
+                  1.0f,
+                  -1.0f
+              ),
+              PID(PID::delta_type,
+                  FOC_CURRENT_KP,
+                  FOC_CURRENT_KI,
+                  FOC_CURRENT_KD,
+                  CURRENT_LOOP_PERIOD,
+                  nullopt,
+                  nullopt,
+                  1.0f,
+                  -1.0f
+              ),
+              PID(PID::position_type,
+                  FOC_SPEED_KP,
+                  FOC_SPEED_KI,
+                  FOC_SPEED_KD,
+                  0.0002f, // 5kHz
+                  2.0f,
+                  -2.0f,
+                  FOC_MAX_CURRENT,
+                  -FOC_MAX_CURRENT
+              ),
+              PID(PID::position_type,
+                  FOC_ANGLE_KP,
+                  FOC_ANGLE_KI,
+                  FOC_ANGLE_KD,
+                  0.0002f, // 5kHz
+                  nullopt,
+                  nullopt,
+                  FOC_MAX_SPEED,
+                  -FOC_MAX_SPEED
+              )
+);
+
+namespace {
+constexpr uint32_t CURRENT_CTRL_FREQUENCY = FOC_CURRENT_LOOP_FREQUENCY;         // 电流环频率,单位Hz
+constexpr uint32_t CTRL_DIVIDER = CURRENT_CTRL_FREQUENCY / 5000;                // 速度环位置环分频
+constexpr uint32_t TASK_DIVIDER = CURRENT_CTRL_FREQUENCY / 1000;                // FOCTask分频
+constexpr float PWM_PERIOD = 1.0f / static_cast<float>(CURRENT_CTRL_FREQUENCY); // 单位s
+
+uint64_t tick = 0; // 已仿真的电流环周期数
+
+/**
+ * @brief 仿真一个电流环周期,对应固件中的一次HAL_ADCEx_InjectedConvCpltCallback
+ */
+void step() {
+    plant.step(bldc_driver.du, bldc_driver.dv, bldc_driver.dw, bldc_driver.enabled, PWM_PERIOD);
+    current_sensor.update();
+#if FOC_VBUS_DMA
+    qd4310.updateVoltage(plant.bus_voltage);
+#endif
+    modulator.update_current(current_sensor.iu, current_sensor.iv, current_sensor.iw);
+    field_weakening.apply(current_sensor, qd4310.getElectricAngle(), qd4310.getInjectedCurrentD());
+    qd4310.loopCtrl();
+    field_weakening.restore(current_sensor);
+    if (qd4310.started) field_weakening.update(modulator.get_utilization());
+    else field_weakening.reset();
+    current_sensor.select_phases(bldc_driver.du, bldc_driver.dv, bldc_driver.dw);
+    ++tick;
+    if (tick % CTRL_DIVIDER == 0) {
+        qd4310.reserveCurrent(field_weakening.get_current());
+        qd4310.Ctrl_ISR();
+    }
+    if (tick % TASK_DIVIDER == 0) {
+#if !FOC_VBUS_DMA
+        qd4310.updateVoltage(plant.bus_voltage);
+#endif
+        qd4310.error_detect();
+    }
+}
+
+void run_for(const float seconds) {
+    const auto steps = static_cast<uint64_t>(seconds * CURRENT_CTRL_FREQUENCY);
+    for (uint64_t i = 0; i < steps; ++i) step();
+}
+
+float sim_time() { return static_cast<float>(tick) * PWM_PERIOD; }
+
+bool report(const char *name, const bool pass, const char *fmt, const float value, const float limit) {
+    printf("[%s] %-8s ", pass ? "PASS" : "FAIL", name);
+    printf(fmt, value, limit);
+    printf("\r\n");
+    return pass;
+}
+
+/**
+ * @brief 设置控制目标并运行一段时间,用于进入稳态或停机
+ */
+void ctrl_for(const QD4310::CtrlType& ctrl, const float seconds) {
+    qd4310.Ctrl(ctrl);
+    run_for(seconds);
+}
+
+/**
+ * @brief 运行steps个电流环周期,每周期结束后调用一次on_step采样
+ */
+template<typename F>
+void sample(const uint32_t steps, F&& on_step) {
+    for (uint32_t i = 0; i < steps; ++i) {
+        step();
+        on_step();
+    }
+}
+
+/**
+ * @brief 采样值的均值、标准差和均方根
+ */
+struct Statistic {
+    double sum = 0, sum_sq = 0;
+    uint32_t count = 0;
+
+    void add(const double value) {
+        sum += value;
+        sum_sq += value * value;
+        ++count;
+    }
+
+    [[nodiscard]] double mean() const { return count ? sum / count : 0.0; }
+    [[nodiscard]] double rms() const { return count ? sqrt(sum_sq / count) : 0.0; }
+    [[nodiscard]] double stddev() const { return sqrt(max(0.0, rms() * rms() - mean() * mean())); }
+};
+
+/**
+ * @brief 场景修改的全局状态在离开作用域时按登记的逆序恢复,后续场景不受影响
+ */
+class Restore {
+public:
+    Restore() = default;
+    Restore(const Restore&) = delete;
+    Restore& operator=(const Restore&) = delete;
+
+    ~Restore() {
+        for (auto it = actions.rbegin(); it != actions.rend(); ++it) (*it)();
+    }
+
+    // 记录变量的当前值,退出时写回
+    template<typename T>
+    void save(T& value) {
+        actions.emplace_back([&value, saved = value] { value = saved; });
+    }
+
+    // 退出时执行的操作,如调用setter或运行一段时间使状态稳定
+    void on_exit(function<void()> action) {
+        actions.push_back(std::move(action));
+    }
+
+private:
+    vector<function<void()>> actions;
+};
+
+/**
+ * @brief 以MotorPlant真实电角度对采样电流做Park变换,与真实Q轴电流之差即为测量误差
+ */
+double measured_iq_error() {
+    const float c = cos(plant.electric_angle()), sn = sin(plant.electric_angle());
+    const float i_alpha = current_sensor.iu;
+    const float i_beta = (current_sensor.iu + 2 * current_sensor.iv) / numbers::sqrt3_v<float>;
+    return -sn * i_alpha + c * i_beta - plant.current_q();
+}
+
+/**
+ * @brief 吞吐量测试: 测量每个电流环周期的主机耗时,并分离出控制器本身的耗时
+ */
+bool scenario_bench() {
+    constexpr uint32_t STEPS = 200'000; // 10s仿真时间
+    qd4310.Ctrl({QD4310::CtrlType::SpeedCtrl, 300});
+
+    using clock = chrono::steady_clock;
+    clock::duration ctrl_time{};
+    const auto begin = clock::now();
+    for (uint32_t i = 0; i < STEPS; ++i) {
+        plant.step(bldc_driver.du, bldc_driver.dv, bldc_driver.dw, bldc_driver.enabled, PWM_PERIOD);
+        current_sensor.update();
+#if FOC_VBUS_DMA
+        qd4310.updateVoltage(plant.bus_voltage);
+#endif
+        const auto t0 = clock::now();
+        modulator.update_current(current_sensor.iu, current_sensor.iv, current_sensor.iw);
+        field_weakening.apply(current_sensor, qd4310.getElectricAngle(), qd4310.getInjectedCurrentD());
+        qd4310.loopCtrl();
+        field_weakening.restore(current_sensor);
+        if (qd4310.started) field_weakening.update(modulator.get_utilization());
+        else field_weakening.reset();
+        current_sensor.select_phases(bldc_driver.du, bldc_driver.dv, bldc_driver.dw);
+        ++tick;
+        if (tick % CTRL_DIVIDER == 0) {
+            qd4310.reserveCurrent(field_weakening.get_current());
+            qd4310.Ctrl_ISR();
+        }
+        ctrl_time += clock::now() - t0;
+        if (tick % TASK_DIVIDER == 0) {
+#if !FOC_VBUS_DMA
+            qd4310.updateVoltage(plant.bus_voltage);
+#endif
+            qd4310.error_detect();
+        }
+    }
+    const auto total = clock::now() - begin;
+
+    const double total_ns = chrono::duration<double, nano>(total).count();
+    const double ctrl_ns = chrono::duration<double, nano>(ctrl_time).count();
+    printf("bench: %u steps (%.1f s simulated) in %.3f s\r\n", STEPS, STEPS * PWM_PERIOD, total_ns * 1e-9);
+    printf("  step       : %8.1f ns/call\r\n", total_ns / STEPS);
+    printf("  controller : %8.1f ns/call (loopCtrl + Ctrl_ISR)\r\n", ctrl_ns / STEPS);
+    printf("  real-time  : x%.1f\r\n", STEPS * PWM_PERIOD / (total_ns * 1e-9));
+    qd4310.Ctrl({QD4310::CtrlType::CurrentCtrl, 0});
+    return true;
+}
+
+/**
+ * @brief CRC8耗时对比: 按通信协议的帧长(接收帧校验4字节,反馈帧校验9字节)比较逐位计算与查表法,
+ *        并换算到4Mbps UART下6000帧/s的CPU占用
+ */
+bool scenario_crc() {
+    constexpr uint32_t FRAMES = 1'000'000;
+    constexpr uint32_t FRAME_RATE = 6000; // 单位帧/s
+    uint8_t rx[4], tx[9];
+    uint32_t seed = 0x12345678;
+    auto random_fill = [&seed](uint8_t *data, const uint32_t len) {
+        for (uint32_t i = 0; i < len; ++i) {
+            seed = seed * 1664525u + 1013904223u;
+            data[i] = static_cast<uint8_t>(seed >> 24);
+        }
+    };
+
+    // 1.一致性检查,覆盖全部单字节输入及随机帧
+    bool match = true;
+    for (uint16_t i = 0; i < 256; ++i) {
+        const auto byte = static_cast<uint8_t>(i);
+        match &= CRC8(&byte, 1, 0x07, 0x00, 0x00, false, false) == CRC8_Protocol::compute(&byte, 1);
+        match &= CRC8(&byte, 1, 0x31, 0xFF, 0x00, true, true) ==
+                 CRC8_Table<0x31, 0xFF, 0x00, true>::compute(&byte, 1);
+    }
+    for (uint32_t i = 0; i < 10000; ++i) {
+        random_fill(tx, sizeof(tx));
+        match &= CRC8(tx, sizeof(tx), 0x07, 0x00, 0x00, false, false) == CRC8_Protocol::compute(tx, sizeof(tx));
+        match &= CRC8(tx, sizeof(tx), 0x1D, 0xFD, 0xFF, true, true) ==
+                 CRC8_Table<0x1D, 0xFD, 0xFF, true>::compute(tx, sizeof(tx));
+    }
+
+    // 2.耗时测量,每帧计算一次接收校验和一次反馈校验
+    using clock = chrono::steady_clock;
+    auto measure = [&](auto &&crc) {
+        volatile uint8_t sink = 0;
+        const auto begin = clock::now();
+        for (uint32_t i = 0; i < FRAMES; ++i) {
+            rx[0] = tx[0] = static_cast<uint8_t>(i);
+            sink = sink + crc(rx, sizeof(rx)) + crc(tx, sizeof(tx));
+        }
+        return chrono::duration<double, nano>(clock::now() - begin).count() / FRAMES;
+    };
+    random_fill(rx, sizeof(rx));
+    random_fill(tx, sizeof(tx));
+    const double bitwise_ns = measure([](const uint8_t *data, const uint32_t len) {
+        return CRC8(data, len, 0x07, 0x00, 0x00, false, false);
+    });
+    const double table_ns = measure([](const uint8_t *data, const uint32_t len) {
+        return CRC8_Protocol::compute(data, len);
+    });
+
+    printf("crc: %u frames, rx check %u bytes + tx frame %u bytes\r\n", FRAMES,
+           static_cast<unsigned>(sizeof(rx)), static_cast<unsigned>(sizeof(tx)));
+    printf("  bitwise : %8.1f ns/frame, %6.3f %% at %u frames/s\r\n",
+           bitwise_ns, bitwise_ns * FRAME_RATE * 1e-7, FRAME_RATE);
+    printf("  table   : %8.1f ns/frame, %6.3f %% at %u frames/s\r\n",
+           table_ns, table_ns * FRAME_RATE * 1e-7, FRAME_RATE);
+    printf("  speedup : x%.1f\r\n", bitwise_ns / table_ns);
+    return report("crc", match, "table mismatches bitwise: %.0f (limit %.0f)", match ? 0.0f : 1.0f, 0.0f);
+}
+
+/**
+ * @brief 转矩脉动随转速的变化: 速度闭环稳态下统计电磁转矩的标准差和平均D轴电流,对比延迟补偿开关
+ */
+bool scenario_ripple() {
+    constexpr float SPEEDS[] = {100.0f, 300.0f, 600.0f, FOC_MAX_SPEED}; // 单位rpm
+    constexpr uint32_t SAMPLES = 4000;                                  // 0.2s
+    Restore restore;
+    restore.save(compensated_encoder.compensation);
+    printf("ripple: delay %.1f us\r\n", compensated_encoder.get_delay() * 1e6f);
+    printf("  %8s %5s %12s %12s %10s\r\n", "rpm", "comp", "torque(mNm)", "ripple(mNm)", "Id(mA)");
+    for (const float speed: SPEEDS) {
+        for (const bool compensation: {false, true}) {
+            compensated_encoder.compensation = compensation;
+            ctrl_for({QD4310::CtrlType::SpeedCtrl, speed}, 0.5f);
+            Statistic torque, id;
+            sample(SAMPLES, [&] {
+                torque.add(plant.torque());
+                id.add(plant.current_d());
+            });
+            printf("  %8.0f %5s %12.3f %12.3f %10.2f\r\n", speed, compensation ? "on" : "off",
+                   torque.mean() * 1e3, torque.stddev() * 1e3, id.mean() * 1e3);
+        }
+    }
+    ctrl_for({QD4310::CtrlType::SpeedCtrl, 0}, 0.5f);
+    return true;
+}
+
+/**
+ * @brief 速度观测对比: 以同一组编码器角度差分分别输入差分低通和PLL观测器,与MotorPlant真实转速比较;
+ *        滞后为加速段按 误差≈加速度·滞后 拟合的等效延迟,噪声为匀速段相对真实转速误差的标准差,均在5kHz速度环时刻采样
+ */
+bool scenario_observer() {
+    constexpr float TARGET = 600.0f;      // 单位rpm
+    constexpr uint32_t TRANSIENT = 2000;  // 0.1s,加速段
+    constexpr uint32_t HOLD = 10000;      // 0.5s,匀速段
+    constexpr float RAD_TO_RPM = 60 / (2 * numbers::pi_v<float>);
+    LowPassFilter_2_Order lpf(PWM_PERIOD, 300);
+    PLL_SpeedObserver pll(PWM_PERIOD, FOC_SPEED_PLL_BANDWIDTH);
+    Filter *observers[] = {&lpf, &pll};
+    const char *names[] = {"lpf 300Hz", "pll"};
+    double lag_num[2]{}, lag_den[2]{};
+    Statistic noise[2];
+
+    float last_angle = bldc_encoder.get_angle(), last_speed = plant.speed_rpm();
+    qd4310.Ctrl({QD4310::CtrlType::SpeedCtrl, TARGET});
+    for (uint32_t i = 0; i < TRANSIENT + HOLD; ++i) {
+        step();
+        const float angle = bldc_encoder.get_angle();
+        float delta = angle - last_angle;
+        if (delta > numbers::pi_v<float>) delta -= 2 * numbers::pi_v<float>;
+        else if (delta < -numbers::pi_v<float>) delta += 2 * numbers::pi_v<float>;
+        last_angle = angle;
+        const float raw = delta / PWM_PERIOD * RAD_TO_RPM;
+        float estimate[2];
+        for (int k = 0; k < 2; ++k) estimate[k] = (*observers[k])(raw);
+        if (tick % CTRL_DIVIDER != 0) continue;
+
+        const float speed = plant.speed_rpm();
+        const float accel = (speed - last_speed) / (PWM_PERIOD * CTRL_DIVIDER); // 单位rpm/s
+        last_speed = speed;
+        for (int k = 0; k < 2; ++k) {
+            if (i < TRANSIENT) {
+                lag_num[k] += static_cast<double>(speed - estimate[k]) * accel;
+                lag_den[k] += static_cast<double>(accel) * accel;
+            } else {
+                noise[k].add(estimate[k] - speed);
+            }
+        }
+    }
+    printf("observer: speed step 0 -> %.0f rpm, sampled at %u Hz\r\n", TARGET, CURRENT_CTRL_FREQUENCY / CTRL_DIVIDER);
+    printf("  %-10s %10s %12s\r\n", "", "lag(us)", "noise(rpm)");
+    for (int k = 0; k < 2; ++k) {
+        printf("  %-10s %10.1f %12.3f\r\n", names[k], lag_num[k] / lag_den[k] * 1e6, noise[k].stddev());
+    }
+    printf("  pll bandwidth %.0f Hz\r\n", pll.get_bandwidth());
+    ctrl_for({QD4310::CtrlType::SpeedCtrl, 0}, 0.5f);
+    return true;
+}
+
+/**
+ * @brief 电流采样过采样: 假定单次转换噪声为2LSB(标准差),速度闭环稳态下对比各过采样倍数的
+ *        Q轴电流测量噪声(测量值与MotorPlant真实值之差的标准差)和电磁转矩脉动
+ */
+bool scenario_adc() {
+    constexpr uint8_t RATIOS[] = {1, 4, 16};
+    constexpr float SPEED = 300.0f;     // 单位rpm
+    constexpr uint32_t SAMPLES = 4000;  // 0.2s
+    Restore restore;
+    restore.save(current_sensor.noise_lsb);
+    restore.save(current_sensor.oversampling);
+    current_sensor.noise_lsb = 2.0f;
+    printf("adc: noise %.1f LSB per conversion, speed %.0f rpm\r\n", current_sensor.noise_lsb, SPEED);
+    printf("  %6s %16s %12s\r\n", "ratio", "Iq noise(mA)", "ripple(mNm)");
+    double first_noise = 0, last_noise = 0;
+    for (const uint8_t ratio: RATIOS) {
+        current_sensor.oversampling = ratio;
+        ctrl_for({QD4310::CtrlType::SpeedCtrl, SPEED}, 0.5f);
+        Statistic error, torque;
+        sample(SAMPLES, [&] {
+            error.add(measured_iq_error());
+            torque.add(plant.torque());
+        });
+        printf("  %6u %16.3f %12.3f\r\n", ratio, error.stddev() * 1e3, torque.stddev() * 1e3);
+        if (ratio == RATIOS[0]) first_noise = error.stddev();
+        last_noise = error.stddev();
+    }
+    ctrl_for({QD4310::CtrlType::SpeedCtrl, 0}, 0.5f);
+    // 16倍过采样噪声应约为1/4,留出量化误差的余量
+    const auto reduction = static_cast<float>(first_noise / last_noise);
+    return report("adc", reduction > 3.0f, "noise reduction x%.2f (limit x%.2f)", reduction, 3.0f);
+}
+
+/**
+ * @brief 高调制深度: 降低母线电压使转速闭环稳态下最大占空比接近1,假定占空比超过0.95时该相采样失效,
+ *        对比两电阻与三电阻采样的Q轴电流测量误差(均方根)和转矩脉动
+ */
+bool scenario_shunt() {
+    constexpr float BUS_VOLTAGE = 16.0f; // 单位V
+    constexpr float SPEED = 420.0f;      // 单位rpm,反电动势约为母线电压的0.8
+    constexpr uint32_t SAMPLES = 4000;   // 0.2s
+    Restore restore;
+    restore.on_exit([] { run_for(0.1f); });
+    restore.save(plant.bus_voltage);
+    restore.save(current_sensor.three_shunt);
+    restore.save(current_sensor.max_duty);
+    plant.bus_voltage = BUS_VOLTAGE;
+    current_sensor.max_duty = 0.95f;
+    printf("shunt: bus %.0f V, speed %.0f rpm, sample invalid above duty %.2f\r\n",
+           BUS_VOLTAGE, SPEED, current_sensor.max_duty);
+    printf("  %8s %10s %16s %12s\r\n", "shunts", "max duty", "Iq error(mA)", "ripple(mNm)");
+    double errors[2]{};
+    for (const bool three_shunt: {false, true}) {
+        current_sensor.three_shunt = three_shunt;
+        ctrl_for({QD4310::CtrlType::SpeedCtrl, SPEED}, 1.0f);
+        Statistic error, torque;
+        float max_duty = 0;
+        sample(SAMPLES, [&] {
+            max_duty = max({max_duty, bldc_driver.du, bldc_driver.dv, bldc_driver.dw});
+            error.add(measured_iq_error());
+            torque.add(plant.torque());
+        });
+        printf("  %8u %10.3f %16.3f %12.3f\r\n", three_shunt ? 3u : 2u, max_duty, error.rms() * 1e3,
+               torque.stddev() * 1e3);
+        errors[three_shunt] = error.rms();
+    }
+    ctrl_for({QD4310::CtrlType::SpeedCtrl, 0}, 0.5f);
+    return report("shunt", errors[1] <= errors[0], "3-shunt Iq error %.4f A (limit %.4f A, 2-shunt)",
+                  static_cast<float>(errors[1]), static_cast<float>(errors[0]));
+}
+
+/**
+ * @brief 母线电压归一化: 转子静止时分别在额定电压和12V下做Q轴电流阶跃,比较1ms时的电流,
+ *        归一化开启时两者应基本一致,关闭时12V下的响应约慢一倍
+ */
+bool scenario_vbus() {
+    constexpr float TARGET = 0.5f;          // 单位A
+    constexpr float LOW_VOLTAGE = 12.0f;    // 单位V
+    constexpr uint32_t RISE_STEPS = 20;     // 1ms
+    Restore restore;
+    restore.on_exit([] { run_for(0.01f); });
+    restore.save(plant.bus_voltage);
+    restore.save(modulator.vbus_compensation);
+    const float nominal_voltage = plant.bus_voltage;
+    // 返回阶跃后RISE_STEPS个周期时的Q轴电流,1ms内转子几乎不动,反电动势可忽略
+    auto step_response = [&](const float voltage) {
+        plant.bus_voltage = voltage;
+        ctrl_for({QD4310::CtrlType::CurrentCtrl, 0}, 0.05f);
+        qd4310.Ctrl({QD4310::CtrlType::CurrentCtrl, TARGET});
+        sample(RISE_STEPS, [] {});
+        const float iq = plant.current_q();
+        ctrl_for({QD4310::CtrlType::CurrentCtrl, 0}, 0.05f);
+        return iq;
+    };
+    printf("vbus: Iq step %.2f A, Iq after %.1f ms\r\n", TARGET, RISE_STEPS * PWM_PERIOD * 1e3f);
+    printf("  %12s %10s %10s\r\n", "compensation", "nominal", "12V");
+    float deviation = 0;
+    for (const bool compensation: {false, true}) {
+        modulator.vbus_compensation = compensation;
+        const float i_nominal = step_response(nominal_voltage);
+        const float i_low = step_response(LOW_VOLTAGE);
+        printf("  %12s %10.4f %10.4f\r\n", compensation ? "on" : "off", i_nominal, i_low);
+        if (compensation) deviation = abs(i_low - i_nominal) / i_nominal;
+    }
+    return report("vbus", deviation < 0.05f, "|Iq(12V) - Iq(nominal)| / Iq = %.3f (limit %.3f)", deviation, 0.05f);
+}
+
+/**
+ * @brief 调制方式: 以正弦相电压参考(幅值为母线电压的m倍)扫过一个电周期,直接调用调制级,
+ *        比较输出线电压与参考线电压的最大误差;SVPWM在m=1/√3时应无削顶,SPWM在m>0.5后削顶
+ */
+bool scenario_svpwm() {
+    constexpr uint32_t POINTS = 3600;
+    constexpr float INDICES[] = {0.5f, 0.55f, 1 / numbers::sqrt3_v<float>};
+    Restore restore;
+    restore.save(modulator.vbus_compensation);
+    restore.save(modulator.modulation);
+    restore.save(bldc_driver.du);
+    restore.save(bldc_driver.dv);
+    restore.save(bldc_driver.dw);
+    modulator.vbus_compensation = false;
+    // 返回线电压(以母线电压为单位)最大误差,同时输出占空比的范围
+    auto sweep = [&](const float m, float& min_duty, float& max_duty) {
+        float error = 0;
+        min_duty = 1, max_duty = 0;
+        for (uint32_t i = 0; i < POINTS; ++i) {
+            const float theta = 2 * numbers::pi_v<float> * static_cast<float>(i) / POINTS;
+            const float u = m * cos(theta);
+            const float v = m * cos(theta - 2 * numbers::pi_v<float> / 3);
+            const float w = m * cos(theta + 2 * numbers::pi_v<float> / 3);
+            modulator.set_duty(0.5f + u, 0.5f + v, 0.5f + w);
+            error = max({error, abs(bldc_driver.du - bldc_driver.dv - (u - v)),
+                         abs(bldc_driver.dv - bldc_driver.dw - (v - w))});
+            min_duty = min({min_duty, bldc_driver.du, bldc_driver.dv, bldc_driver.dw});
+            max_duty = max({max_duty, bldc_driver.du, bldc_driver.dv, bldc_driver.dw});
+        }
+        return error;
+    };
+    printf("svpwm: line voltage error over one electrical cycle (unit: bus voltage)\r\n");
+    printf("  %10s %8s %12s %10s %10s\r\n", "modulation", "index", "max error", "min duty", "max duty");
+    float error = 0;
+    for (const auto modulation: {BLDC_Modulator::Modulation::SPWM, BLDC_Modulator::Modulation::SVPWM}) {
+        modulator.modulation = modulation;
+        for (const float m: INDICES) {
+            float min_duty, max_duty;
+            const float e = sweep(m, min_duty, max_duty);
+            printf("  %10s %8.4f %12.6f %10.4f %10.4f\r\n",
+                   modulation == BLDC_Modulator::Modulation::SVPWM ? "SVPWM" : "SPWM", m, e, min_duty, max_duty);
+            if (modulation == BLDC_Modulator::Modulation::SVPWM) error = max(error, e);
+        }
+    }
+    return report("svpwm", error < 1e-5f, "SVPWM line voltage error up to m=1/sqrt3 %.6f (limit %.6f)", error, 1e-5f);
+}
+
+/**
+ * @brief 弱磁与过调制: 降低母线电压使最高转速低于限速,分别比较线性调制、弱磁、弱磁加过调制下空载稳态转速和D轴电流
+ */
+bool scenario_weakening() {
+    constexpr float BUS_VOLTAGE = 12.0f; // 单位V
+    constexpr float MAX_CURRENT = 1.0f;  // 最大弱磁电流,单位A
+    constexpr float OVERMODULATION = 2.0f;
+    constexpr uint32_t SAMPLES = 2000;   // 0.1s
+    Restore restore;
+    restore.on_exit([] { run_for(0.1f); });
+    restore.save(plant.bus_voltage);
+    restore.on_exit([current = field_weakening.get_max_current()] { field_weakening.set_max_current(current); });
+    restore.on_exit([utilization = modulator.get_max_utilization()] {
+        modulator.set_max_utilization(utilization);
+    });
+    plant.bus_voltage = BUS_VOLTAGE;
+    printf("weakening: bus %.0f V, target %.0f rpm\r\n", BUS_VOLTAGE, FOC_MAX_SPEED);
+    printf("  %-22s %10s %10s %12s\r\n", "mode", "speed", "Id(A)", "utilization");
+    static constexpr struct {
+        const char *name;
+        float max_current;
+        float overmodulation;
+    } MODES[] = {
+        {"linear", 0.0f, 1.0f},
+        {"field weakening", MAX_CURRENT, 1.0f},
+        {"fw + overmodulation", MAX_CURRENT, OVERMODULATION},
+    };
+    float speeds[3]{};
+    for (uint32_t i = 0; i < 3; ++i) {
+        field_weakening.set_max_current(MODES[i].max_current);
+        modulator.set_max_utilization(MODES[i].overmodulation);
+        ctrl_for({QD4310::CtrlType::SpeedCtrl, FOC_MAX_SPEED}, 1.5f);
+        Statistic speed, id, utilization;
+        sample(SAMPLES, [&] {
+            speed.add(plant.speed_rpm());
+            id.add(plant.current_d());
+            utilization.add(modulator.get_utilization());
+        });
+        speeds[i] = static_cast<float>(speed.mean());
+        printf("  %-22s %10.1f %10.3f %12.3f\r\n", MODES[i].name, speeds[i], id.mean(), utilization.mean());
+        ctrl_for({QD4310::CtrlType::SpeedCtrl, 0}, 1.0f);
+    }
+    return report("weakening", speeds[1] > speeds[0] && speeds[2] > speeds[1],
+                  "fw + overmodulation speed %.1f rpm (must exceed linear %.1f rpm)", speeds[2], speeds[0]);
+}
+
+/**
+ * @brief 死区补偿: 给逆变器加入500ns死区,按固件calibrate deadtime的流程(转子静止,两个正D轴电流下的D轴电压)估计死区,
+ *        再比较补偿前后低速匀速时的转矩脉动和Q轴电流谐波(均方根)
+ */
+bool scenario_deadtime() {
+    constexpr float DEAD_TIME = 500e-9f * FOC_PWM_FREQUENCY; // 500ns
+    constexpr float CURRENTS[] = {0.3f * FOC_DEAD_TIME_CAL_CURRENT, FOC_DEAD_TIME_CAL_CURRENT};
+    constexpr float SPEED = 30.0f;     // 单位rpm
+    constexpr uint32_t SAMPLES = 8000; // 0.4s
+    Restore restore;
+    restore.on_exit([] { run_for(0.1f); });
+    restore.on_exit([dead_time = modulator.get_dead_time()] { modulator.set_dead_time(dead_time, FOC_DEAD_TIME_BAND); });
+    restore.save(plant.dead_time);
+    plant.dead_time = DEAD_TIME;
+
+    // 校准
+    modulator.set_dead_time(0, FOC_DEAD_TIME_BAND);
+    qd4310.Ctrl({QD4310::CtrlType::CurrentCtrl, 0});
+    float vd[2]{};
+    for (uint32_t i = 0; i < 2; ++i) {
+        qd4310.injectCurrentD(CURRENTS[i]);
+        run_for(0.2f);
+        sample(200, [&] { vd[i] += modulator.get_voltage_d(qd4310.getElectricAngle()) / 200; });
+    }
+    const float theta = qd4310.getElectricAngle();
+    qd4310.injectCurrentD(0);
+    run_for(0.1f);
+    const float estimate = BLDC_Modulator::dead_time_from_voltages(theta, CURRENTS[0], vd[0], CURRENTS[1], vd[1]);
+    const float estimate_error = abs(estimate - DEAD_TIME) / DEAD_TIME;
+    printf("deadtime: actual %.0f ns, calibrated %.0f ns\r\n", DEAD_TIME / FOC_PWM_FREQUENCY * 1e9f,
+           estimate / FOC_PWM_FREQUENCY * 1e9f);
+
+    // 补偿前后对比
+    printf("  %12s %12s %14s\r\n", "compensation", "ripple(mNm)", "Iq harm(mA)");
+    double ripples[2]{};
+    for (const bool compensation: {false, true}) {
+        modulator.set_dead_time(compensation ? estimate : 0, FOC_DEAD_TIME_BAND);
+        ctrl_for({QD4310::CtrlType::SpeedCtrl, SPEED}, 1.0f);
+        Statistic torque, iq;
+        sample(SAMPLES, [&] {
+            torque.add(plant.torque());
+            iq.add(plant.current_q());
+        });
+        printf("  %12s %12.3f %14.3f\r\n", compensation ? "on" : "off", torque.stddev() * 1e3, iq.stddev() * 1e3);
+        ripples[compensation] = torque.stddev();
+    }
+    ctrl_for({QD4310::CtrlType::SpeedCtrl, 0}, 0.5f);
+    bool pass = report("dt_cal", estimate_error < 0.2f, "|Td_cal - Td| / Td = %.3f (limit %.3f)", estimate_error, 0.2f);
+    pass &= report("dt_comp", ripples[1] < ripples[0], "ripple with compensation %.5f Nm (limit %.5f Nm)",
+                   static_cast<float>(ripples[1]), static_cast<float>(ripples[0]));
+    return pass;
+}
+
+/**
+ * @brief 定点坐标变换: 遍历电流和电角度,对比Q15与浮点Clarke+Park的最大误差,并测量主机上的耗时
+ */
+bool scenario_fixed() {
+    constexpr float FULL_SCALE = 1.65f; // 单位A,与CurrentSensor_Embed的Q15满量程一致
+    constexpr float LIMIT = 5.0f;       // 单位LSB,与FixedPointFOC.h中正余弦插值的误差上限一致
+    constexpr uint32_t CALLS = 10'000'000;
+    using q15 = FixedPointFOC::q15;
+
+    // 1.误差: 电流幅值取满量程的0.1~0.5(三相电流均不超量程),电角度每圈1024点
+    float max_error = 0;
+    for (const float amplitude: {0.1f, 0.3f, 0.5f}) {
+        for (uint32_t k = 0; k < 1024; ++k) {
+            const auto theta = static_cast<uint16_t>(k << 6);
+            const float rad = static_cast<float>(theta) * (2 * numbers::pi_v<float> / 65536);
+            const float phase = rad + 0.3f; // 电流矢量超前电角度,使d、q均不为0
+            const float iu = amplitude * FULL_SCALE * cos(phase);
+            const float iv = amplitude * FULL_SCALE * cos(phase - 2 * numbers::pi_v<float> / 3);
+
+            const float alpha = iu, beta = (iu + 2 * iv) / numbers::sqrt3_v<float>;
+            const float d = alpha * cos(rad) + beta * sin(rad);
+            const float q = beta * cos(rad) - alpha * sin(rad);
+
+            q15 alpha_q, beta_q, d_q, q_q;
+            FixedPointFOC::clarke(FixedPointFOC::from_float(iu, FULL_SCALE), FixedPointFOC::from_float(iv, FULL_SCALE),
+                                  alpha_q, beta_q);
+            FixedPointFOC::park(alpha_q, beta_q, FixedPointFOC::sin(theta), FixedPointFOC::cos(theta), d_q, q_q);
+            max_error = max({max_error, abs(d / FULL_SCALE * 32768 - d_q), abs(q / FULL_SCALE * 32768 - q_q)});
+        }
+    }
+
+    // 2.耗时
+    using clock = chrono::steady_clock;
+    auto measure = [](auto &&transform) {
+        const auto begin = clock::now();
+        for (uint32_t i = 0; i < CALLS; ++i) transform(i);
+        return chrono::duration<double, nano>(clock::now() - begin).count() / CALLS;
+    };
+    volatile float sink_f = 0.1f;
+    volatile q15 sink_q = 1000;
+    const double float_ns = measure([&](const uint32_t i) {
+        const float iu = sink_f, iv = sink_f, rad = static_cast<float>(i) * 1e-4f;
+        const float alpha = iu, beta = (iu + 2 * iv) / numbers::sqrt3_v<float>;
+        const float s = sin(rad), c = cos(rad);
+        sink_f = alpha * c + beta * s;
+        sink_f = beta * c - alpha * s;
+    });
+    const double fixed_ns = measure([&](const uint32_t i) {
+        q15 alpha, beta, d, q;
+        FixedPointFOC::clarke(sink_q, sink_q, alpha, beta);
+        const auto theta = static_cast<uint16_t>(i << 6);
+        FixedPointFOC::park(alpha, beta, FixedPointFOC::sin(theta), FixedPointFOC::cos(theta), d, q);
+        sink_q = d;
+        sink_q = q;
+    });
+
+    printf("fixed: clarke+park, full scale %.2f A (1 LSB = %.1f uA)\r\n", FULL_SCALE, FULL_SCALE / 32768 * 1e6f);
+    printf("  float : %8.1f ns/call\r\n", float_ns);
+    printf("  q15   : %8.1f ns/call\r\n", fixed_ns);
+    return report("fixed", max_error <= LIMIT, "max |q15 - float| = %.0f LSB (limit %.0f LSB)", max_error, LIMIT);
+}
+
+/**
+ * @brief 电流阶跃: 负载转矩抵消电磁转矩使转子近似静止,检查Q轴电流跟踪
+ */
+bool scenario_current() {
+    constexpr float TARGET = 0.5f; // 单位A
+    constexpr uint32_t SAMPLES = 1000;
+    Restore restore;
+    restore.on_exit([] { run_for(0.05f); });
+    restore.save(plant.load_torque);
+    plant.load_torque = FOC_TORQUE_CONSTANT * TARGET;
+    ctrl_for({QD4310::CtrlType::CurrentCtrl, TARGET}, 0.05f);
+    Statistic iq;
+    sample(SAMPLES, [&] { iq.add(plant.current_q()); });
+    qd4310.Ctrl({QD4310::CtrlType::CurrentCtrl, 0});
+    const auto error = static_cast<float>(abs(iq.mean() - TARGET));
+    return report("current", error < 0.1f * TARGET, "|Iq - Iq_ref| = %.4f A (limit %.4f A)", error, 0.1f * TARGET);
+}
+
+/**
+ * @brief 速度阶跃: 检查1s后的稳态转速误差
+ */
+bool scenario_speed() {
+    constexpr float TARGET = 300.0f; // 单位rpm
+    ctrl_for({QD4310::CtrlType::SpeedCtrl, TARGET}, 1.0f);
+    const float error = abs(plant.speed_rpm() - TARGET);
+    const bool pass = report("speed", error < 0.05f * TARGET, "|n - n_ref| = %.2f rpm (limit %.2f rpm)",
+                             error, 0.05f * TARGET);
+    ctrl_for({QD4310::CtrlType::SpeedCtrl, 0}, 0.5f);
+    return pass;
+}
+
+/**
+ * @brief 角度阶跃: 检查1s后的稳态角度误差
+ */
+bool scenario_angle() {
+    constexpr float TARGET = numbers::pi_v<float> / 2; // 单位rad
+    ctrl_for({QD4310::CtrlType::AngleCtrl, TARGET}, 1.0f);
+    float error = abs(qd4310.getAngle() - TARGET);
+    error = min(error, 2 * numbers::pi_v<float> - error);
+    return report("angle", error < 0.01f, "|theta - theta_ref| = %.4f rad (limit %.4f rad)", error, 0.01f);
+}
+
+/**
+ * @brief 多圈角度控制: 依次转到+10.25圈和-3.5圈,检查稳态位置误差,并与转子实际转过的圈数比较
+ */
+bool scenario_position() {
+    constexpr float TARGETS[] = {10.25f, -3.5f}; // 单位圈,相对起始位置
+    constexpr float LIMIT = 0.01f;               // 单位rad
+    const int64_t origin = qd4310.getPosition();
+    double plant_turns = 0; // 由MotorPlant角度展开得到的转过圈数
+    float last_theta = plant.mechanical_angle();
+    bool pass = true;
+    for (const float turns: TARGETS) {
+        const int64_t target = origin + QD4310::radian_to_position(turns * 2 * numbers::pi_v<float>);
+        pass &= qd4310.CtrlPosition(target);
+        for (uint32_t i = 0; i < 2 * CURRENT_CTRL_FREQUENCY; ++i) { // 2s
+            step();
+            float delta = plant.mechanical_angle() - last_theta;
+            if (delta > numbers::pi_v<float>) delta -= 2 * numbers::pi_v<float>;
+            else if (delta < -numbers::pi_v<float>) delta += 2 * numbers::pi_v<float>;
+            last_theta = plant.mechanical_angle();
+            plant_turns += delta / (2 * numbers::pi_v<float>);
+        }
+        const float error = abs(QD4310::position_to_radian(qd4310.getPosition() - target));
+        const float plant_error = static_cast<float>(abs(plant_turns - turns) * 2 * numbers::pi);
+        char name[16];
+        snprintf(name, sizeof(name), "pos%+.2f", turns);
+        pass &= report(name, error < LIMIT && plant_error < LIMIT + 0.001f,
+                       "|p - p_ref| = %.4f rad (limit %.4f rad)", max(error, plant_error), LIMIT);
+    }
+    pass &= qd4310.isPositionCtrl();
+    qd4310.Ctrl({QD4310::CtrlType::SpeedCtrl, 0});
+    pass &= !qd4310.isPositionCtrl();
+    run_for(0.2f);
+    return pass;
+}
+
+struct Scenario {
+    const char *name;
+    bool (*run)();
+};
+
+constexpr Scenario scenarios[] = {
+    {"current", scenario_current},
+    {"speed", scenario_speed},
+    {"angle", scenario_angle},
+    {"bench", scenario_bench},
+    {"crc", scenario_crc},
+    {"ripple", scenario_ripple},
+    {"observer", scenario_observer},
+    {"position", scenario_position},
+    {"adc", scenario_adc},
+    {"fixed", scenario_fixed},
+    {"shunt", scenario_shunt},
+    {"vbus", scenario_vbus},
+    {"svpwm", scenario_svpwm},
+    {"weakening", scenario_weakening},
+    {"deadtime", scenario_deadtime},
+};
+}
+
+/**
+ * @brief 仿真中的延时即推进仿真时间,QDrive在校准等阻塞流程中调用
+ */
+void qdrive_delay_ms(const uint32_t ms) {
+    run_for(static_cast<float>(ms) * 1e-3f);
+}
+
+int main(const int argc, char *argv[]) {
+    const char *selected = argc > 1 ? argv[1] : "all";
+
+    compensated_encoder.set_speed_source([] {
+        return qd4310.getSpeed() * (2 * numbers::pi_v<float> / 60); // rpm转rad/s
+    });
+    // 母线电压来源始终设置,是否归一化由vbus_compensation决定,可用config pwm.vbus_comp切换
+    modulator.set_voltage_source([] { return qd4310.getVoltage(); });
+    modulator.vbus_compensation = FOC_VBUS_COMPENSATION;
+    modulator.modulation = FOC_MODULATION_SVPWM ? BLDC_Modulator::Modulation::SVPWM
+                                                : BLDC_Modulator::Modulation::SPWM;
+    modulator.set_max_utilization(FOC_OVERMODULATION);
+    qd4310.updateVoltage(plant.bus_voltage);
+    qd4310.init();
+    modulator.set_dead_time(qd4310.getDeadTime() * FOC_PWM_FREQUENCY, FOC_DEAD_TIME_BAND);
+    qd4310.enable();
+    run_for(0.01f);
+    if (!qd4310.start()) {
+        printf("qd4310 start failed, error code 0x%02X\r\n", static_cast<unsigned>(qd4310.error_code));
+        return 2;
+    }
+
+    bool pass = true, found = false;
+    for (const auto& scenario: scenarios) {
+        if (strcmp(selected, "all") != 0 && strcmp(selected, scenario.name) != 0) continue;
+        found = true;
+        pass &= scenario.run();
+    }
+    if (!found) {
+        printf("usage: %s [all", argv[0]);
+        for (const auto& scenario: scenarios) printf("|%s", scenario.name);
+        printf("]\r\n");
+        return 2;
+    }
+    printf("simulated %.3f s\r\n", sim_time());
+    return pass ? 0 : 1;
+}
@@ -3,8 +3,8 @@
  * @brief       QD4310电机控制库
  * @details
  * @author      Liu-Curiousity (2675794963@qq.com)
- * @date        2026-7-2
- * @version     V1.4.0
+ * @date        2026-10-17
+ * @version     V1.13.0
  * @note
  * @warning
  * @par         历史版本:
@@ -17,29 +17,59 @@
  *		        V1.3.0创建于2026-5-30, 优化初始化时从储存器读取参数的流程,添加清除校准数据的功能
  *		        V1.3.1修改于2026-6-14,适配PID重构,修复若干问题
  *		        V1.4.0修改于2026-7-2,添加错误检测
+ *		        V1.5.0修改于2026-10-17,添加电角度获取接口,供示波器记录使用
+ *		        V1.6.0修改于2026-10-17,添加控制周期超时警告
+ *		        V1.7.0修改于2026-10-17,添加编码器错误帧警告
+ *		        V1.8.0修改于2026-10-17,添加多圈位置累计与多圈角度控制,可选掉电保存位置
+ *		        V1.9.0修改于2026-10-17,添加校准进行中标志,供电流零点跟踪判断空闲
+ *		        V1.10.0修改于2026-10-17,添加死区时间参数及其储存
+ *		        V1.11.0修改于2026-10-17,添加电流环倍频未能开启的错误
+ *		        V1.11.1修改于2026-10-17,掉电位置记录魔术字最后写入,读取后作废,掉电检测加回差
+ *		        V1.12.0修改于2026-10-17,添加reserveCurrent(),Q轴电流限幅扣除电流环外注入的D轴电流
+ *		        V1.12.1修改于2026-10-17,RateError仅在线电流采样硬件开启倍频时可能出现
+ *		        V1.12.2修改于2026-10-17,电流限幅变化后的目标电流重新限幅移至Ctrl_ISR,Ctrl()在临界区内修改控制目标
+ *		        V1.13.0修改于2026-10-17,添加injectCurrentD(),供校准在电流环外注入D轴电流
  * @copyright   (c) 2026 QDrive
  */
 
 #include "QD4310.h"
 #include "QDrive_cfg.h"
 #include <algorithm>
+#include <cmath>
 #include <numbers>
 #include "usart.h"
 
 using namespace std;
 
+static constexpr double POSITION_PER_TURN = 4294967296.0; // 多圈位置每圈的定点数,2^32
+
+/**
+ * @brief 角度转为一圈内的定点小数
+ * @param angle 角度,单位rad,范围[0,2pi]
+ * @return 单位2^-32圈,2pi回绕为0
+ */
+static uint32_t angle_to_fraction(const float angle) {
+    constexpr float SCALE = static_cast<float>(POSITION_PER_TURN) / (2 * numbers::pi_v<float>);
+    return static_cast<uint32_t>(static_cast<int64_t>(angle * SCALE));
+}
+
 void QD4310::init() {
     // 1.初始化flash
     if (!storage.initialized)
         storage.init();
     // 2.从flash中读取校准数据
+    dead_time = FOC_DEAD_TIME;
     load_storage_calibration();
+    max_current = PID_Speed.output_limit_p.value_or(FOC_MAX_CURRENT);
+#if FOC_POSITION_PERSIST
+    load_position();
+#endif
     // 3.初始化FOC
     QDrive::init();
 }
 
 bool QD4310::start() {
-    if (error_code == NoError) QDrive::start();
+    if ((error_code & ~WARNING_MASK) == NoError) QDrive::start();
     if (started) return true;
     else return false;
 }
@@ -48,6 +78,8 @@ bool QD4310::stop() {
     QDrive::stop();
     if (!started) {
         QDrive::Ctrl({CtrlType::CurrentCtrl, 0});
+        injected_id = 0.0f;
+        apply_current_limit();
         return true;
     }
     return false;
@@ -55,8 +87,10 @@ bool QD4310::stop() {
 
 auto QD4310::calibrate() -> CalibrationStatus {
     if (error_code & VoltageError) return CalibrationStatus::VoltageError;          // 如果电压异常,则不能校准
-    if (error_code & ~CalibrationError) return CalibrationStatus::EnvironmentError; // 如果有错误,则不能校准
+    if (error_code & ~(CalibrationError | WARNING_MASK)) return CalibrationStatus::EnvironmentError; // 如果有错误,则不能校准
+    calibrating = true;
     const auto status = QDrive::calibrate();
+    calibrating = false;
     if (status == CalibrationStatus::Success)      // 如果基础校准成功
         freeze_storage(STORAGE_BASE_CALIBRATE_OK); // 保存基础校准数据
     // else if (status == CalibrationStatus::CurrentSensorError ||
@@ -68,8 +102,10 @@ auto QD4310::calibrate() -> CalibrationStatus {
 }
 
 void QD4310::anticogging_calibrate() {
-    if (error_code != NoError) return; // 如果有错误,则不能校准
+    if (error_code & ~WARNING_MASK) return; // 如果有错误,则不能校准
+    calibrating = true;
     QDrive::anticogging_calibrate();
+    calibrating = false;
     if (anticogging_calibrated)                           // 如果齿槽转矩补偿校准成功
         freeze_storage(STORAGE_ANTICOGGING_CALIBRATE_OK); // 储存齿槽转矩补偿表
 }
@@ -78,20 +114,109 @@ void QD4310::anticogging_calibrate() {
     return wrap(QDrive::getAngle() - zero_pos, 0, 2 * numbers::pi_v<float>);
 }
 
+[[nodiscard]] float QD4310::getElectricAngle() const {
+    return wrap(QDrive::getAngle() * FOC_POLE_PAIRS - zero_electric_angle, 0, 2 * numbers::pi_v<float>);
+}
+
 bool QD4310::Ctrl(CtrlType ctrl_type) {
     if (!started) return false;
-    if (error_code != NoError) return false;
-    if (ctrl_type.type == CtrlType::AngleCtrl) {
+    if (error_code & ~WARNING_MASK) return false;
+    if (ctrl_type.type == CtrlType::AngleCtrl)
         ctrl_type.value = wrap(ctrl_type.value + zero_pos, 0, 2 * numbers::pi_v<float>);
+    // Ctrl_ISR()中同样会调用QDrive::Ctrl(),修改控制目标期间屏蔽中断,避免两者交错
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    position_ctrl = false;
+    if (ctrl_type.type == CtrlType::CurrentCtrl) {
+        current_target = ctrl_type.value;
+        const float iq_max = current_q_limit();
+        ctrl_type.value = std::clamp(ctrl_type.value, -iq_max, iq_max);
     }
     QDrive::Ctrl(ctrl_type);
+    __set_PRIMASK(primask);
     return true;
 }
 
 void QD4310::Ctrl_ISR() {
+    update_position();
+    if (current_limit_changed) {
+        current_limit_changed = false;
+        // 电流控制模式下目标电流按新的限幅重新限幅
+        if (started && getCtrlType().type == CtrlType::CurrentCtrl) {
+            const float iq_max = current_q_limit();
+            const float target = std::clamp(current_target, -iq_max, iq_max);
+            if (target != getCtrlType().value) QDrive::Ctrl({CtrlType::CurrentCtrl, target});
+        }
+    }
+    if (position_ctrl) {
+        if (started && getCtrlType().type == CtrlType::AngleCtrl) {
+            const float angle = position_step_angle(position, position_target);
+            QDrive::Ctrl({CtrlType::AngleCtrl, wrap(angle + zero_pos, 0, 2 * numbers::pi_v<float>)});
+        } else {
+            position_ctrl = false; // 电机已停止或被切换控制模式
+        }
+    }
     QDrive::Ctrl_ISR();
 }
 
+int64_t QD4310::getPosition() const {
+    int64_t value;
+    do { value = position; } while (value != position); // 64位读取不是原子操作,被Ctrl_ISR打断时重读
+    return value;
+}
+
+float QD4310::position_to_radian(const int64_t position) {
+    return static_cast<float>(static_cast<double>(position) * (2 * numbers::pi / POSITION_PER_TURN));
+}
+
+int64_t QD4310::radian_to_position(const float radian) {
+    return llround(static_cast<double>(radian) * (POSITION_PER_TURN / (2 * numbers::pi)));
+}
+
+bool QD4310::CtrlPosition(const int64_t position_) {
+    if (!position_valid) return false;
+    if (!Ctrl({CtrlType::AngleCtrl, position_step_angle(getPosition(), position_)})) return false;
+    position_target = position_;
+    position_ctrl = true;
+    return true;
+}
+
+/**
+ * @brief 由角度回绕累计多圈位置,在Ctrl_ISR中调用
+ * @note 两次调用间转动需小于半圈(5kHz下即150000rpm),低32位之差按int32解释即为带符号的角度增量
+ */
+void QD4310::update_position() {
+    if (!enabled) return; // 编码器未使能时角度无效
+    const uint32_t fraction = angle_to_fraction(getAngle());
+    if (!position_valid) {
+        int64_t initial = fraction; // 第0圈
+        if (position_restored) {
+            // 按离掉电保存位置最近的圈数对齐当前角度,断电期间转动不超过半圈即可恢复
+            initial = position_stored + static_cast<int32_t>(fraction - static_cast<uint32_t>(position_stored));
+            position_restored = false;
+        }
+        position = initial;
+        position_valid = true;
+        return;
+    }
+    const int64_t last = position;
+    position = last + static_cast<int32_t>(fraction - static_cast<uint32_t>(last));
+}
+
+/**
+ * @brief 多圈角度控制中交给角度环的目标角度
+ * @note 目标距离超过1/4圈时只前进1/4圈,角度环输出已被限速,效果与直接跟踪远处目标相同
+ * @param current 当前位置,单位2^-32圈
+ * @param target 目标位置,单位2^-32圈
+ * @return 角度环目标,单位rad,范围[0,2pi]
+ */
+float QD4310::position_step_angle(const int64_t current, const int64_t target) {
+    constexpr int64_t MAX_STEP = int64_t{1} << 30; // 1/4圈
+    const int64_t step = clamp(target - current, -MAX_STEP, MAX_STEP);
+    return static_cast<float>(static_cast<uint32_t>(current + step)) *
+           static_cast<float>(2 * numbers::pi / POSITION_PER_TURN);
+}
+
 bool QD4310::setID(const uint8_t id) {
     if (id > 7) return false; // ID必须在0-7之间
     ID = id;
@@ -129,16 +254,56 @@ bool QD4310::setLimit(const std::optional<float> speed_limit, const std::optiona
         PID_Angle.output_limit_n = -speed_limit.value();
     }
     if (current_limit) {
-        PID_Speed.output_limit_p = current_limit.value();
-        PID_Speed.output_limit_n = -current_limit.value();
+        max_current = current_limit.value();
+        apply_current_limit();
     }
     return true;
 }
 
+void QD4310::reserveCurrent(const float id) {
+    if (id == reserved_id) return;
+    reserved_id = id;
+    apply_current_limit();
+}
+
+bool QD4310::injectCurrentD(const float id) {
+    if (id != 0.0f && !started) return false;
+    if (!(std::abs(id) <= max_current)) return false;
+    injected_id = id;
+    apply_current_limit();
+    return true;
+}
+
+/**
+ * @brief Q轴电流限幅,合成电流限制扣除预留和注入的D轴电流
+ */
+float QD4310::current_q_limit() const {
+    const float id = reserved_id + injected_id;
+    return sqrtf(std::max(max_current * max_current - id * id, 0.0f));
+}
+
+/**
+ * @brief 更新速度环输出限幅,电流控制模式下的目标电流由下一次Ctrl_ISR()重新限幅
+ */
+void QD4310::apply_current_limit() {
+    const float iq_max = current_q_limit();
+    PID_Speed.output_limit_p = iq_max;
+    PID_Speed.output_limit_n = -iq_max;
+    current_limit_changed = true;
+}
+
 bool QD4310::setZeroPosition(const std::optional<float> position) {
     if (started) return false; // 如果电机已经启动,则不能设置零点
     zero_pos = wrap(zero_pos + position.value_or(getAngle()), 0, 2 * numbers::pi_v<float>);
     freeze_storage(STORAGE_ZERO_POS_OK);
+    position_restored = false; // 掉电保存的位置以旧零点为参考,不再恢复
+    position_valid = false;    // 多圈位置从新零点的第0圈重新累计
+    return true;
+}
+
+bool QD4310::setDeadTime(const float dead_time_) {
+    if (!(dead_time_ >= 0 && dead_time_ <= 2e-6f)) return false; // 死区时间必须在0-2us之间
+    dead_time = dead_time_;
     return true;
 }
 
@@ -176,9 +341,21 @@ auto QD4310::error_detect() -> ErrorCode {
     } else {
         error_code = static_cast<ErrorCode>(error_code & ~CalibrationError);
     }
-    if (error_code != NoError) stop();
-    // 如果有除timeout以外的错误,则闪报警灯
-    if (error_code & ~TimeoutError) {
+    if (error_code & ~WARNING_MASK) stop(); // 警告不停止电机
+#if FOC_POSITION_PERSIST
+    // 电压由正常跌落到最小电压以下视为掉电,电机停止后保存多圈位置;
+    // 回升到最小电压加回差以上才重新准备保存,避免电压在阈值附近波动时反复擦写Flash页;
+    // 保存后电压恢复而未复位时作废记录,之后的复位(看门狗、reboot等)不会恢复过时的位置
+    if (power_good && Voltage < FOC_ABSOLUTE_MIN_VOLTAGE) {
+        save_position();
+        power_good = false;
+    } else if (!power_good && Voltage >= FOC_ABSOLUTE_MIN_VOLTAGE + FOC_POSITION_HYSTERESIS) {
+        if (position_saved) clear_position();
+        power_good = true;
+    }
+#endif
+    // 如果有除timeout和警告以外的错误,则闪报警灯
+    if (error_code & ~(TimeoutError | WARNING_MASK)) {
         HAL_GPIO_WritePin(LED_G_GPIO_Port, LED_G_Pin, GPIO_PIN_SET);
         static uint16_t count = 0;
         count = (count + 1) % 100; // 1kHz/100/2 = 5Hz
@@ -200,10 +377,12 @@ void QD4310::restore_calibration() {
     setID(0);
     setTimeout(0);
     setUartBaudRate(115200);
+    setDeadTime(FOC_DEAD_TIME);
 
     freeze_storage(
         static_cast<StorageStatus>(STORAGE_PID_PARAMETER_OK | // 储存PID参数
-                                   STORAGE_PLUG_OK)           // 储存ID
+                                   STORAGE_PLUG_OK |          // 储存ID
+                                   STORAGE_DEAD_TIME_OK)      // 储存死区时间
     );
 }
 
@@ -245,6 +424,9 @@ void QD4310::load_storage_calibration() {
     if ((storage_status & STORAGE_ZERO_POS_OK) == STORAGE_ZERO_POS_OK) {
         storage.read(0x400, &zero_pos, sizeof(zero_pos));
     }
+    if ((storage_status & STORAGE_DEAD_TIME_OK) == STORAGE_DEAD_TIME_OK) {
+        storage.read(0x500, &dead_time, sizeof(dead_time));
+    }
     if ((storage_status & STORAGE_ANTICOGGING_CALIBRATE_OK) == STORAGE_ANTICOGGING_CALIBRATE_OK) {
         storage.read(0x800, anticogging_map, sizeof(anticogging_map));
         anticogging_calibrated = true;
@@ -292,7 +474,7 @@ void QD4310::freeze_storage(const StorageStatus storage_type) {
         *reinterpret_cast<decltype(PID_Angle.ki) *>(&storage_buffer[0x040]) = PID_Angle.ki;
         *reinterpret_cast<decltype(PID_Angle.kd) *>(&storage_buffer[0x050]) = PID_Angle.kd;
         *reinterpret_cast<decltype(PID_Angle.output_limit_p) *>(&storage_buffer[0x060]) = PID_Angle.output_limit_p;
-        *reinterpret_cast<decltype(PID_Speed.output_limit_p) *>(&storage_buffer[0x070]) = PID_Speed.output_limit_p;
+        *reinterpret_cast<decltype(PID_Speed.output_limit_p) *>(&storage_buffer[0x070]) = max_current; // 不含弱磁预留
         storage.write(0x200, storage_buffer, 0x080);
     }
     if ((storage_type & STORAGE_PLUG_OK) == STORAGE_PLUG_OK) {
@@ -306,6 +488,10 @@ void QD4310::freeze_storage(const StorageStatus storage_type) {
         // 储存位置零点
         storage.write(0x400, &zero_pos, sizeof(zero_pos));
     }
+    if ((storage_type & STORAGE_DEAD_TIME_OK) == STORAGE_DEAD_TIME_OK) {
+        // 储存死区时间
+        storage.write(0x500, &dead_time, sizeof(dead_time));
+    }
     if ((storage_type & STORAGE_ANTICOGGING_CALIBRATE_OK) == STORAGE_ANTICOGGING_CALIBRATE_OK) {
         // 储存齿槽转矩补偿表
         storage.write(0x800, anticogging_map, sizeof(anticogging_map));
@@ -336,3 +522,37 @@ void QD4310::clear_storage(const StorageStatus storage_type) const {
     storage_status = static_cast<StorageStatus>(storage_status & ~storage_type);
     storage.write(0x010, &storage_status, sizeof(storage_status));
 }
+
+/**
+ * @brief 保存多圈位置
+ * @note 只写入单独的一页,掉电过程中写入失败也不会破坏校准数据
+ */
+void QD4310::save_position() {
+    static_assert(0x800 + sizeof(anticogging_map) <= STORAGE_POSITION_ADDR, "齿槽转矩补偿表与多圈位置储存区重叠");
+    if (!position_valid) return;
+    PositionRecord record{getPosition(), 0, STORAGE_POSITION_MAGIC};
+    storage.write(STORAGE_POSITION_ADDR, &record, sizeof(record));
+    position_saved = true;
+}
+
+/**
+ * @brief 读取掉电保存的多圈位置,在第一次更新多圈位置时与当前角度对齐
+ * @note 读取后立即作废记录,只有紧接着掉电的这一次上电会恢复位置
+ */
+void QD4310::load_position() {
+    PositionRecord record{};
+    storage.read(STORAGE_POSITION_ADDR, &record, sizeof(record));
+    if (record.magic != STORAGE_POSITION_MAGIC) return;
+    position_stored = record.position;
+    position_restored = true;
+    clear_position();
+}
+
+/**
+ * @brief 作废掉电保存的多圈位置
+ */
+void QD4310::clear_position() {
+    PositionRecord record{};
+    storage.write(STORAGE_POSITION_ADDR, &record, sizeof(record));
+    position_saved = false;
+}
@@ -3,8 +3,8 @@
  * @brief       QD4310电机控制库
  * @details
  * @author      Liu-Curiousity (2675794963@qq.com)
- * @date        2026-7-2
- * @version     V1.4.0
+ * @date        2026-10-17
+ * @version     V1.13.0
  * @note
  * @warning
  * @par         历史版本:
@@ -17,6 +17,18 @@
  *		        V1.3.0创建于2026-5-30, 优化初始化时从储存器读取参数的流程,添加清除校准数据的功能
  *		        V1.3.1修改于2026-6-14,适配PID重构,修复若干问题
  *		        V1.4.0修改于2026-7-2,添加错误检测
+ *		        V1.5.0修改于2026-10-17,添加电角度获取接口,供示波器记录使用
+ *		        V1.6.0修改于2026-10-17,添加控制周期超时警告
+ *		        V1.7.0修改于2026-10-17,添加编码器错误帧警告
+ *		        V1.8.0修改于2026-10-17,添加多圈位置累计与多圈角度控制,可选掉电保存位置
+ *		        V1.9.0修改于2026-10-17,添加校准进行中标志,供电流零点跟踪判断空闲
+ *		        V1.10.0修改于2026-10-17,添加死区时间参数及其储存
+ *		        V1.11.0修改于2026-10-17,添加电流环倍频未能开启的错误
+ *		        V1.11.1修改于2026-10-17,掉电位置记录魔术字最后写入,读取后作废,掉电检测加回差
+ *		        V1.12.0修改于2026-10-17,添加reserveCurrent(),Q轴电流限幅扣除电流环外注入的D轴电流
+ *		        V1.12.1修改于2026-10-17,RateError仅在线电流采样硬件开启倍频时可能出现
+ *		        V1.12.2修改于2026-10-17,电流限幅变化后的目标电流重新限幅移至Ctrl_ISR,Ctrl()在临界区内修改控制目标
+ *		        V1.13.0修改于2026-10-17,添加injectCurrentD(),供校准在电流环外注入D轴电流
  * @copyright   (c) 2026 QDrive
  */
 
@@ -35,8 +47,14 @@ public:
         VoltageError = 0b0000'0010,
         TimeoutError = 0b0000'0100,
         TemperatureError = 0b0000'1000,
+        OverrunError = 0b0001'0000, // 控制周期超时,仅为警告,不停止电机,需clearError()清除
+        EncoderError = 0b0010'0000, // 编码器出现错误帧(已被丢弃),仅为警告,需clearError()清除
+        RateError = 0b0100'0000,    // 编译为电流环倍频(仅在线电流采样硬件)但中断耗时超出预算而未开启,控制参数与实际频率不符,禁止启动,需关闭倍频重新编译
     } error_code = NoError;
 
+    // 警告类错误码,不影响电机运行
+    static constexpr uint8_t WARNING_MASK = OverrunError | EncoderError;
+
     /**
      * @brief 初始化
      * @param pole_pairs 极对数
@@ -83,6 +101,38 @@ public:
     // 获取电机角度,单位rad
     [[nodiscard]] float getAngle() const;
 
+    // 获取电角度(不含位置零点偏置),单位rad
+    [[nodiscard]] float getElectricAngle() const;
+
+    /**
+     * @brief 获取多圈位置
+     * @return 定点数,单位为2^-32圈,低32位与getAngle()对应,高32位为圈数
+     * @note 位置在Ctrl_ISR中按角度回绕累计,整数累加不随圈数增大而丢失精度
+     */
+    [[nodiscard]] int64_t getPosition() const;
+
+    // 多圈位置与弧度互相转换,单位rad
+    static float position_to_radian(int64_t position);
+    static int64_t radian_to_position(float radian);
+
+    /**
+     * @brief 多圈角度控制,目标超出半圈时按角度环限速转动多圈到达
+     * @param position 目标位置,单位为2^-32圈,与getPosition()一致
+     * @return 设置成功返回true,失败返回false
+     * @note 以AngleCtrl实现,此后调用Ctrl()或电机停止即退出多圈控制
+     */
+    bool CtrlPosition(int64_t position);
+
+    /**
+     * @brief 是否处于多圈角度控制
+     */
+    [[nodiscard]] bool isPositionCtrl() const { return position_ctrl; }
+
+    /**
+     * @brief 是否正在进行校准(基础校准或齿槽转矩校准),校准期间未启动但驱动输出电压
+     */
+    [[nodiscard]] bool isCalibrating() const { return calibrating; }
+
     /**
      * @brief QD4310控制设置函数
      * @param ctrl_type 控制类型
@@ -123,6 +173,35 @@ public:
         error_code = static_cast<ErrorCode>(error_code & ~TimeoutError);
     }
 
+    /**
+     * @brief 上报控制周期超时,置位OverrunError
+     * @note 由监测控制中断实时性的一方调用
+     */
+    void reportOverrun() {
+        error_code = static_cast<ErrorCode>(error_code | OverrunError);
+    }
+
+    /**
+     * @brief 上报编码器错误帧,置位EncoderError
+     */
+    void reportEncoderError() {
+        error_code = static_cast<ErrorCode>(error_code | EncoderError);
+    }
+
+    /**
+     * @brief 上报电流环倍频未能开启,置位RateError,不可清除
+     */
+    void reportRateError() {
+        error_code = static_cast<ErrorCode>(error_code | RateError);
+    }
+
+    /**
+     * @brief 清除警告类错误码,其余错误码由error_detect()根据实际状态更新
+     */
+    void clearError() {
+        error_code = static_cast<ErrorCode>(error_code & ~WARNING_MASK);
+    }
+
     /**
      * @brief 设置PID参数
      * @param pid_speed_kp 速度环比例系数
@@ -148,6 +227,23 @@ public:
      */
     bool setLimit(std::optional<float> speed_limit, std::optional<float> current_limit);
 
+    /**
+     * @brief 预留电流环外注入的D轴电流(如弱磁),Q轴电流限幅降为√(limit²-id²),合成电流不超过电流限制
+     * @param id D轴电流,单位A
+     * @note 在速度环中断中Ctrl_ISR()之前调用;电流控制模式下的目标电流由Ctrl_ISR()同样按此限幅
+     */
+    void reserveCurrent(float id);
+
+    /**
+     * @brief 在电流环外注入D轴电流(如死区校准时保持转子不动),与弱磁电流叠加,Q轴电流限幅同样扣除
+     * @param id D轴电流,单位A,0为取消
+     * @return 电机未启动(id非0时)或超出电流限制返回false
+     * @note 由电流环中断按getInjectedCurrentD()叠加到FieldWeakening::apply();stop()时清零
+     */
+    bool injectCurrentD(float id);
+
+    [[nodiscard]] float getInjectedCurrentD() const { return injected_id; } // 电流环外注入的D轴电流,单位A
+
     /**
      * @brief 设置位置零点
      * @param position 位置零点,单位rad
@@ -162,6 +258,19 @@ public:
      */
     bool setUartBaudRate(uint32_t baud_rate);
 
+    /**
+     * @brief 设置死区补偿使用的死区时间
+     * @param dead_time_ 死区时间,单位s,范围[0,2e-6],0表示不补偿
+     * @return 设置成功返回true,失败返回false
+     */
+    bool setDeadTime(float dead_time_);
+
+    /**
+     * @brief 获取死区时间
+     * @return 死区时间,单位s
+     */
+    [[nodiscard]] float getDeadTime() const { return dead_time; }
+
 protected:
     friend class ShellPlugs;
 
@@ -172,11 +281,13 @@ protected:
         STORAGE_PID_PARAMETER_OK = 0b0000'0100,
         STORAGE_PLUG_OK = 0b0000'1000,
         STORAGE_ZERO_POS_OK = 0b0001'0000,
+        STORAGE_DEAD_TIME_OK = 0b0010'0000,
         STORAGE_ALL_OK = STORAGE_BASE_CALIBRATE_OK |
                          STORAGE_ANTICOGGING_CALIBRATE_OK |
                          STORAGE_PID_PARAMETER_OK |
                          STORAGE_PLUG_OK |
-                         STORAGE_ZERO_POS_OK,
+                         STORAGE_ZERO_POS_OK |
+                         STORAGE_DEAD_TIME_OK,
     };
 
     static constexpr uint8_t STORAGE_MAGIC = 0xAA; // 存储器魔术字,储存在0x000
@@ -185,6 +296,41 @@ protected:
     float zero_pos{0.0f};     // 位置零点, 单位rad
     float timeout{0.0f};      // 超时时间, 单位s
     float timeout_time{0.0f}; // 超时计时器, 单位s
+    float dead_time{0.0f};    // 死区时间, 单位s
+    float max_current{0.0f};  // 电流限制(合成电流), 单位A
+    float reserved_id{0.0f};  // 电流环外注入的D轴电流(弱磁), 单位A
+    float injected_id{0.0f};  // 校准等由injectCurrentD()注入的D轴电流, 单位A
+    float current_target{0.0f}; // 电流控制模式下设置的目标电流, 单位A
+
+    // 掉电保存的多圈位置,单独占用储存区最后一页,写入时不擦除校准数据所在页
+    static constexpr uint32_t STORAGE_POSITION_ADDR = 0x2000;
+    static constexpr uint32_t STORAGE_POSITION_MAGIC = 0x504F5332; // "POS2"
+
+    // Flash按地址顺序逐个双字编程,魔术字放在最后一个双字,写入中途掉电时魔术字仍为擦除值,记录无效
+    struct PositionRecord {
+        int64_t position;
+        uint32_t reserved;
+        uint32_t magic;
+    };
+
+    volatile int64_t position{0};            // 多圈位置,单位2^-32圈
+    volatile int64_t position_target{0};     // 多圈角度控制目标,单位2^-32圈
+    volatile bool position_valid{false};     // 多圈位置已初始化
+    volatile bool position_ctrl{false};      // 处于多圈角度控制
+    volatile bool calibrating{false};        // 正在校准
+    volatile bool current_limit_changed{false}; // 电流限幅已变化,待Ctrl_ISR()重新限幅目标电流
+    bool position_restored{false};           // 已从储存器读取掉电保存的位置
+    int64_t position_stored{0};              // 掉电保存的位置,单位2^-32圈
+    bool power_good{false};                  // 电压正常,跌落后需回升到最小电压加回差才重新置位
+    bool position_saved{false};              // 本次上电后已保存过掉电位置
+
+    void update_position();
+    static float position_step_angle(int64_t current, int64_t target);
+    void save_position();
+    void load_position();
+    void clear_position();
+    [[nodiscard]] float current_q_limit() const;
+    void apply_current_limit();
 
     void restore_calibration();
     void load_storage_calibration();
@@ -0,0 +1,17 @@
+set(CMAKE_SYSTEM_NAME               Linux)
+set(CMAKE_SYSTEM_PROCESSOR          x86_64)
+
+# Host simulation build, native gcc must be part of path environment
+set(CMAKE_C_COMPILER                gcc)
+set(CMAKE_CXX_COMPILER              g++)
+
+set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -Wall -Wextra -Wpedantic -fdata-sections -ffunction-sections")
+if(CMAKE_BUILD_TYPE MATCHES Debug)
+    set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -Og -g3")
+endif()
+if(CMAKE_BUILD_TYPE MATCHES Release)
+    set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -O2 -g0")
+endif()
+
+# 与固件保持一致: 不使用RTTI和异常
+set(CMAKE_CXX_FLAGS "${CMAKE_C_FLAGS} -fno-rtti -fno-exceptions -fno-threadsafe-statics")